@@ -36,16 +36,136 @@
 	Version 3.5, 3.6:
 	Improved Bound for Number of Closed Polygons
 
+	Version 3.7:
+	Multithreaded Enumeration of Prefix Ranges, Work Stealing
+
+	Version 3.8:
+	Checkpoint Files, Resume Interrupted Runs
+
+	Version 3.9:
+	Streaming Analysis of Polygons in Sorted Runs on Disk
+
+	Version 3.10:
+	Growable Paged Storage for Polygon Codes
+
+	Version 3.11:
+	Optional Hash Set of Primitive Polygons, Filled During Enumeration
+
+	Version 3.12:
+	Bit-Parallel Primitive Codes and Symmetry Analysis
+
+	Version 3.13:
+	Parallel Radix Sort of Primitive Codes, Duplicates and Symmetry Handled in the Final Pass
+
+	Version 3.14:
+	Overlap Check by Occupancy Map of Lattice Sites (alternative to distance check)
+
+	Version 3.15:
+	Depth-First Search Engine, Chains Beyond 64-Bit Codes
+
+	Version 3.16:
+	Polygons From Pairs of Half-Chains (meet in the middle)
+
+	Version 3.17:
+	Enumeration Engines Specialized on Chain Length (template instances for 20 ... 62 segments)
+
+	Version 3.18:
+	Packed Lattice Sites With Table-Driven Turns, SIMD Distance Check (alternatives to distance check)
+
+	Version 3.19:
+	Batches of Sibling Chains:  All Tails of a Head Without Overlaps Screened at Once
+
+	Version 3.20:
+	Reduced Enumeration by Chain Reversal Symmetry (one chain of each reverse pair, exact totals)
+
+	Version 3.21:
+	Sweeps Over Chain Lengths, Results Table, Frontier Cache of Live Prefixes
+
+	Version 3.22:
+	Chain Length From Command Line, Results as JSON or CSV (counts, symmetry classes, timings)
+
+	Version 3.23:
+	Hot-Path Counters per Thread (built with USE_COUNTERS), Timing by Steady Clock
+
+	Version 3.24:
+	Benchmark Suite Over All Engines, Counts Checked Against Embedded Table of Known Results
+
+	Version 3.25:
+	Catalogs of Unique Polygons (sorted, delta-coded, memory-mapped reader), Catalog Check
+
+	Version 3.26:
+	Statistics of Open Chains (end-to-end distance, radius of gyration) Gathered During Enumeration
+
+	Version 3.27:
+	In-Place Analysis of Polygons (American flag sort within polygon storage, no second array)
+
+	Version 3.28:
+	Library Interface (2DChain Library.h, build with BUILD_LIBRARY):  Chains Streamed to a Callback, Polygons Reduced,
+	Classified and Rebuilt on Request
+
+	Version 3.29:
+	Transfer-Matrix Count of Closed Chains (no enumeration, sharded tables of boundary states, memory limit)
+
 	CPU Version, January 2014 - May 2014
 	By Christian Bracher */
 
 #include "stdafx.h"
+#include "2DChain Library.h"
+#include "2DChain Known Results.h"
 #include <stdio.h>
 #include <iostream>
 
 /* Support for Timing */
 
 #include <time.h>
+#include <chrono>
+
+/* Support for Peak Memory of the Process, Memory-Mapped Catalogs */
+
+#if defined (_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* Support for Bit Scan Intrinsics */
+
+#if defined (_MSC_VER)
+#include <intrin.h>
+#endif
+
+/* Support for SIMD Intrinsics (SSE2) */
+
+#if defined (__SSE2__) || defined (_M_X64)
+#define HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+/* Support for Multithreading */
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <array>
+#include <string>
+
+/* Support for Streaming Polygon Analysis */
+
+#include <algorithm>
+#include <queue>
+#include <map>
+#include <functional>
+#include <sstream>
+#include <iomanip>
 
 /* Check for 64-bit support (necessary) */
 
@@ -161,6 +281,112 @@ public:
 	}
 };
 
+/* *** BIT MANIPULATION SUPPORT *** */
+
+inline uint64 ReverseBits (uint64 Word)
+{
+/* Reverse the Order of All 64 Bits in a Word (swap neighboring bits, pairs, nibbles, bytes, ...) */
+	Word = ((Word >> 1) & 0x5555555555555555ULL) | ((Word & 0x5555555555555555ULL) << 1);
+	Word = ((Word >> 2) & 0x3333333333333333ULL) | ((Word & 0x3333333333333333ULL) << 2);
+	Word = ((Word >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((Word & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	Word = ((Word >> 8) & 0x00FF00FF00FF00FFULL) | ((Word & 0x00FF00FF00FF00FFULL) << 8);
+	Word = ((Word >> 16) & 0x0000FFFF0000FFFFULL) | ((Word & 0x0000FFFF0000FFFFULL) << 16);
+
+	return (Word >> 32) | (Word << 32);
+}
+
+inline int LowestBit (uint64 Word)
+{
+/* Position of Lowest Set Bit in a Word (Word must not be zero) */
+#if defined (_MSC_VER)
+	unsigned long Position;
+	_BitScanForward64(&Position, Word);
+	return (int)Position;
+#else
+	return __builtin_ctzll(Word);
+#endif
+}
+
+inline int BitCount (uint64 Word)
+{
+/* Number of Set Bits in a Word */
+#if defined (_MSC_VER)
+	return (int)__popcnt64(Word);
+#else
+	return __builtin_popcountll(Word);
+#endif
+}
+
+inline int HighestBit (uint64 Word)
+{
+/* Position of Highest Set Bit in a Word (Word must not be zero) */
+#if defined (_MSC_VER)
+	unsigned long Position;
+	_BitScanReverse64(&Position, Word);
+	return (int)Position;
+#else
+	return 63 - __builtin_clzll(Word);
+#endif
+}
+
+/* *** HOT-PATH COUNTERS *** */
+
+/* Built with USE_COUNTERS defined, every thread counts the work done in the inner loops of the code engine:
+   branching segments, segments rebuilt, distances measured per overlap check, sizes of smart jumps, outcomes of
+   closed loop checks, batches of tails and chains skipped by reversal symmetry.  Each thread reports its rates
+   at the regular progress report, and the totals of all threads are shown after the enumeration.  Without
+   USE_COUNTERS, the counting statements vanish from the code. */
+
+#if defined (USE_COUNTERS)
+#define COUNT(...)  __VA_ARGS__
+#else
+#define COUNT(...)
+#endif
+
+/* Number of Bins of Histograms (covers all chain lengths) */
+const int HistogramBins = 128;
+
+struct HotPathCounters
+{
+/* Counters of a Single Thread (all of type uint64) */
+
+/* Chains Examined, Histogram of Branching Segments */
+	uint64 Chains;
+	uint64 Branching[HistogramBins];
+
+/* Segments Rebuilt, Overlap Checks and Distances Measured in Them */
+	uint64 SegmentsRebuilt;
+	uint64 OverlapChecks;
+	uint64 Distances;
+
+/* Histogram of Smart Jumps by Size (number of segments cut off) */
+	uint64 Jumps[HistogramBins];
+
+/* Closed Loop Checks Passed and Failed, Batches of Tails, Chains Skipped for Their Reverse */
+	uint64 LoopsClosed;
+	uint64 LoopsOpen;
+	uint64 Batches;
+	uint64 ReversalSkips;
+
+	void Clear ()
+	{
+		memset(this, 0, sizeof(HotPathCounters));
+	}
+
+	void Add (const HotPathCounters &Other)
+	{
+		uint64 *Target = (uint64 *)this;
+		const uint64 *Source = (const uint64 *)&Other;
+
+		for (size_t i = 0; i < sizeof(HotPathCounters) / sizeof(uint64); ++i)  Target[i] += Source[i];
+	}
+};
+
+#if defined (USE_COUNTERS)
+/* Counters of the Running Thread */
+static thread_local HotPathCounters ThreadCounters;
+#endif
+
 class PolyMath
 {
 /* Functions Manipulating Codes Representing Closed-Loop Chains */
@@ -274,24 +500,8 @@ public:
 
 	void Revert (void)
 	{
-	/* Revert Polygon Chain */
-		uint64 RevertedCode = 0;
-
-	/* Trace Through Segments (Beginning Toward End) */
-		for (int k = 0; k < Length; ++k)
-		{
-
-		/* Find Source Segment */
-			uint64 SourceSegment = (Code & ((uint64)1 << k));
-
-		/* Add As Target Segment in Reverse */
-			if (SourceSegment == 0)
-			{
-				RevertedCode |= ((uint64)1 << (Length - k - 1));
-			}
-		}
-
-		Code = RevertedCode;
+	/* Revert Polygon Chain:  Reverse Bit Order, Exchange Turns */
+		Code = ReverseBits(~Code & CodeMask()) >> (64 - Length);
 	}
 
 /* Reflect A Polygon Chain */
@@ -309,60 +519,75 @@ public:
 		Code ^= InvertCode;
 	}
 
-/* Find Primitive Code of Closed Chain (rotated/reverted version with smallest code number) */
+/* Bit-Parallel Tools for Codes of Closed Chains */
 
-	void Reduce (void)
+	inline uint64 CodeMask (void)
 	{
-	/* Storage for Smallest Code Found */
-		uint64 MinCode = (((uint64)1 << Length) - 1);
+	/* Template With One Bit Set per Segment */
+		return (((uint64)1 << Length) - 1);
+	}
 
-	/* *** Step #1: Build Reverted Chain Code (reversed reading direction, reversed turns) */
+	inline uint64 RotateRight (uint64 Word, int Steps)
+	{
+	/* Rotate Chain Code by a Number of Segments (0 <= Steps < Length) */
+		if (Steps == 0)  return Word;
 
-	/* Create Variable for Reverted Code */
-		uint64 RevertedCode = 0;
+		return ((Word >> Steps) | (Word << (Length - Steps))) & CodeMask();
+	}
 
-	/* Trace Through Segments (Beginning Toward End) */
-		for (int k = 0; k < Length; ++k)
-		{
+	uint64 MinimalRotation (uint64 Word)
+	{
+	/* Find Smallest Code Among All Rotated Versions of a Chain Code
 
-		/* Find Source Segment */
-			uint64 SourceSegment = (Code & ((uint64)1 << k));
+	   Method: The smallest rotation must start (in its highest bits) with the longest run of left turns
+	   (zero bits) in the closed chain.  ANDing the complement with rotated copies of itself marks the
+	   start of every such run in a single word, so that only these few rotations need to be compared. */
 
-		/* Add As Target Segment in Reverse */
-			if (SourceSegment == 0)
-			{
-				RevertedCode |= ((uint64)1 << (Length - k - 1));
-			}
-		}
+		uint64 Mask = CodeMask();
+		uint64 Zeros = ~Word & Mask;
 
-	/* *** Step 2: Loop Through Rotated Versions of Chain, Reverted Chain */
+	/* No Left Turns:  All Rotations Are the Same */
+		if (Zeros == 0)  return Word;
 
-		for (int j = 0; j < 2; ++j)
+	/* Positions Starting a Run of RunLength Zeros (run extends toward lower bits) */
+		uint64 RunStarts = Zeros;
+
+		for (int RunLength = 1; RunLength < Length; ++RunLength)
 		{
-		/* Select First Original, Then Reverted Chain */
-			if (j > 0)  Code = RevertedCode;
+			uint64 Longer = RunStarts & (((Zeros << RunLength) | (Zeros >> (Length - RunLength))) & Mask);
 
-			for (int i = 0; i < Length; ++i)
-			{
-			/* Check Codes */
-				if (Code < MinCode)  MinCode = Code;
+			if (Longer == 0)  break;
+			RunStarts = Longer;
+		}
 
-			/* Rotate Chain One Segment:  Isolate Last Segment in Chain */
-				int FinalStep = (Code & 1);
+	/* Compare Candidates:  Rotate Each Run Start Into Highest Bit */
+		uint64 MinCode = Mask;
 
-			/* Shift Chain One Segment To Right */
-				Code >>= 1;
+		while (RunStarts != 0)
+		{
+			int Position = LowestBit(RunStarts);
+			RunStarts &= (RunStarts - 1);
 
-			/* Make Last Segment First Segment */
-				if (FinalStep == 1)
-				{
-					Code |= ((uint64)1 << (Length - 1));
-				}
-			}
+			uint64 Candidate = RotateRight(Word, (Position + 1) % Length);
+			if (Candidate < MinCode)  MinCode = Candidate;
 		}
 
+		return MinCode;
+	}
+
+/* Find Primitive Code of Closed Chain (rotated/reverted version with smallest code number) */
+
+	void Reduce (void)
+	{
+	/* Reverted Chain Code (reversed reading direction, reversed turns) */
+		uint64 RevertedCode = ReverseBits(~Code & CodeMask()) >> (64 - Length);
+
+	/* Smallest Rotated Version of Chain, Reverted Chain */
+		uint64 MinCode = MinimalRotation(Code);
+		uint64 MinRevertedCode = MinimalRotation(RevertedCode);
+
 	/* Replace Code by Primitive Code */
-		Code = MinCode;
+		Code = (MinRevertedCode < MinCode) ? MinRevertedCode : MinCode;
 	}
 
 /* Symmetry Functions */
@@ -371,92 +596,142 @@ public:
 
 	int RotationalSymmetry (void)
 	{
-	/* Create Copy of Code */
-		uint64 WorkCode = Code;
-
-	/* Rotational Symmetry Parameter */
-		int PtGrp = 0;
-
-	/* Loop Thru Rotated Versions of Chain */
-		for (int i = 0; i < Length; ++i)
+	/* Number of Rotated Versions of Chain Identical to Original:  Length / (Shortest Period of Code) */
+		for (int Period = 1; Period < Length; ++Period)
 		{
-		/* Check Code - Got Original Back? */
-			if (Code == WorkCode)  ++PtGrp;
-
-		/* Rotate Chain One Segment:  Isolate Last Segment in Chain */
-			int FinalStep = (WorkCode & 1);
-
-		/* Shift Chain One Segment To Right */
-			WorkCode >>= 1;
-
-		/* Make Last Segment First Segment */
-			if (FinalStep == 1)
-			{
-				WorkCode |= ((uint64)1 << (Length - 1));
-			}
+			if (((Length % Period) == 0) && (RotateRight(Code, Period) == Code))  return Length / Period;
 		}
 
-	/* Return Result */
-		return PtGrp;
+		return 1;
 	}
 
 /* Examine Mirror Symmetry */
 	bool MirrorSymmetry (void)
 	{
-	/* *** Step #1: Build Inverted Chain Code (reversed reading direction) */
+	/* Inverted Chain Code (reversed reading direction) Must Be a Rotated Version of the Original */
+		uint64 InvertCode = ReverseBits(Code) >> (64 - Length);
 
-	/* Create Variable for Inverted Code */
-		uint64 InvertCode = 0;
+		return (MinimalRotation(InvertCode) == MinimalRotation(Code));
+	}
 
-	/* Trace Through Segments (Beginning Toward End) */
-		for (int k = 0; k < Length; ++k)
-		{
+/* Primitive Code and Symmetry in One Pass */
 
-		/* Find Source Segment */
-			uint64 SourceSegment = (Code & ((uint64)1 << k));
+	void Canonicalize (int &RotSym, bool &MirrSymm)
+	{
+	/* Replace Code by Primitive Code, Determine Rotational Symmetry and Mirror Symmetry */
+		uint64 Mask = CodeMask();
 
-		/* Add As Target Segment, If Necessary */
-			if (SourceSegment > 0)
-			{
-				InvertCode |= ((uint64)1 << (Length - k - 1));
-			}
-		}
+		uint64 MinCode = MinimalRotation(Code);
+		uint64 MinRevertedCode = MinimalRotation(ReverseBits(~Code & Mask) >> (64 - Length));
+		uint64 MinInvertCode = MinimalRotation(ReverseBits(Code) >> (64 - Length));
+
+		MirrSymm = (MinInvertCode == MinCode);
+
+		Code = (MinRevertedCode < MinCode) ? MinRevertedCode : MinCode;
+		RotSym = RotationalSymmetry();
+	}
+};
 
-	/* *** Step #2:  Rotate & Compare */
 
-	/* Flag for Symmetry */
-		bool IsMirrorSymmetric = false;
+struct SymmetryCensus
+{
+/* Counters for the Symmetry Classes of Unique Polygons
+   (Note:  Possibilities are 1, 2, 3, 6-fold rotational symmetry, perhaps with additional mirror symmetry.) */
+	uint64 SC1;
+	uint64 SC1m;
+	uint64 SC2;
+	uint64 SC2m;
+	uint64 SC3;
+	uint64 SC3m;
+	uint64 SC6;
+	uint64 SC6m;
+
+	SymmetryCensus ()
+	{
+	/* Default Constructor */
+		SC1 = 0;
+		SC1m = 0;
+		SC2 = 0;
+		SC2m = 0;
+		SC3 = 0;
+		SC3m = 0;
+		SC6 = 0;
+		SC6m = 0;
+	}
+
+	SymmetryCensus &operator += (const SymmetryCensus &Other)
+	{
+	/* Collect Counters of Another Census */
+		SC1 += Other.SC1;
+		SC1m += Other.SC1m;
+		SC2 += Other.SC2;
+		SC2m += Other.SC2m;
+		SC3 += Other.SC3;
+		SC3m += Other.SC3m;
+		SC6 += Other.SC6;
+		SC6m += Other.SC6m;
+
+		return *this;
+	}
+
+	int Add (PolyMath Polygon)
+	{
+	/* Analyze for Rotational and Mirror Symmetry
+	   Function Value Returned is the Symmetry Class (0 ... 7, in the order of the counters; -1: none) */
+		int RotSym;
+		bool MirrSymm;
+
+		Polygon.Canonicalize(RotSym, MirrSymm);
 
-	/* Loop Thru Rotated Versions of Chain */
-		for (int i = 0; i < Length; ++i)
+	/* Count Occurrences */
+		if (MirrSymm == true)
 		{
-		/* Check Code - Is a Rotated Version of the Inverted Code the Original Code? */
-			if ((InvertCode == Code))
+		/* Symmetry Classes With Mirror Symmetry */
+			switch (RotSym)
 			{
-				IsMirrorSymmetric = true;
+			case 1:
+				++SC1m;
+				return 1;
+			case 2:
+				++SC2m;
+				return 3;
+			case 3:
+				++SC3m;
+				return 5;
+			case 6:
+				++SC6m;
+				return 7;
+			default:
 				break;
 			}
-
-		/* Rotate Chain One Segment:  Isolate Last Segment in Chain */
-			int FinalStep = (InvertCode & 1);
-
-		/* Shift Chain One Segment To Right */
-			InvertCode >>= 1;
-
-		/* Make Last Segment First Segment */
-			if (FinalStep == 1)
+		}
+		else
+		{
+		/* Symmetry Classes Without Mirror Symmetry */
+			switch (RotSym)
 			{
-				InvertCode |= ((uint64)1 << (Length - 1));
+			case 1:
+				++SC1;
+				return 0;
+			case 2:
+				++SC2;
+				return 2;
+			case 3:
+				++SC3;
+				return 4;
+			case 6:
+				++SC6;
+				return 6;
+			default:
+				break;
 			}
 		}
 
-	/* Return Result */
-		return IsMirrorSymmetric;
+		return -1;
 	}
 };
 
-
-void BuildChain (uint64 Code, int length, LatticeVector *ChainArray)
+inline void BuildChain (uint64 Code, int length, LatticeVector *ChainArray)
 {
 /* Build a Complete Chain
    Translate the Binary Code Into the Actual Lattice Points Occupied by the Chain
@@ -546,6 +821,7 @@ inline void RebuildChain (uint64 Code, int StartPos, int length, LatticeVector *
 	}
 
 /* *** Task #2:  Reconstruct End of Chain */
+	COUNT(ThreadCounters.SegmentsRebuilt += length - StartPos + 1);
 
 	for (int k = StartPos; k <= length; ++k)
 	{
@@ -583,6 +859,8 @@ inline int ChainOverlap (int segment, int length, LatticeVector *ChainArray)
    It is impossible to form loops with less than six atoms.
    The number of segments between two lattice points is at least their L1 distance. */
 
+	COUNT(++ThreadCounters.OverlapChecks);
+
 /* Loop Through "Target Atoms" */
 	for (int k1 = segment; k1 <= length ; ++k1)
 	{
@@ -593,6 +871,7 @@ inline int ChainOverlap (int segment, int length, LatticeVector *ChainArray)
 		{
 		/* Find Distance in L1 Metric */
 			int separation = ChainArray[k1].distance(ChainArray[k2]);
+			COUNT(++ThreadCounters.Distances);
 
 			if (separation == 0)
 			{
@@ -610,17 +889,153 @@ inline int ChainOverlap (int segment, int length, LatticeVector *ChainArray)
 	return 0;
 }
 
-bool ClosedLoopCheck (int length, LatticeVector *ChainArray)
+/* *** OCCUPANCY MAP OVERLAP CHECK *** */
+
+/* Alternative to the distance walk of ChainOverlap:  every atom of the current chain is marked in a bitmap
+   of lattice sites.  The honeycomb lattice is embedded in the plane n1 + n2 + n3 = 0 or 1 of the cubic grid,
+   so a site is fixed by (n1, n2) and the parity n1 + n2 + n3.  A chain starting at the origin stays within
+   L1 distance Length from it, which bounds n1 and n2 and makes the map small enough for the L1 cache. */
+
+enum OverlapEngine {OverlapByDistance = 0, OverlapByBitmap = 1, OverlapByPackedSites = 2, OverlapByPackedSimd = 3};
+
+class OccupancyMap
+{
+/* Bitmap of Lattice Sites Occupied by Atoms 0 ... Top of a Chain */
+public:
+	int Radius;
+	int Width;
+	int Top;
+	std::vector<uint64> Bits;
+
+	OccupancyMap ()
+	{
+	/* Default Constructor:  Empty Map */
+		Radius = 0;
+		Width = 0;
+		Top = -1;
+	}
+
+	void Reset (int length, LatticeVector *ChainArray)
+	{
+	/* Prepare Map for Chains of Given Length, Mark the Fixed Head of the Chain (atoms 0, 1, 2) */
+		Radius = length;
+		Width = 2 * length + 1;
+
+		Bits.assign(((size_t)Width * Width * 2 + 63) / 64, 0);
+
+		for (int k = 0; k <= 2; ++k)  Set(ChainArray[k]);
+		Top = 2;
+	}
+
+	inline size_t Site (const LatticeVector &r)
+	{
+	/* Dense Index of a Lattice Site */
+		return (((size_t)(r.n1 + Radius) * Width + (r.n2 + Radius)) << 1) + (r.n1 + r.n2 + r.n3);
+	}
+
+	inline bool IsOccupied (const LatticeVector &r)
+	{
+		size_t Index = Site(r);
+		return ((Bits[Index >> 6] >> (Index & 63)) & 1) != 0;
+	}
+
+	inline void Set (const LatticeVector &r)
+	{
+		size_t Index = Site(r);
+		Bits[Index >> 6] |= ((uint64)1 << (Index & 63));
+	}
+
+	inline void Clear (const LatticeVector &r)
+	{
+		size_t Index = Site(r);
+		Bits[Index >> 6] &= ~((uint64)1 << (Index & 63));
+	}
+};
+
+inline int RebuildChainWithMap (uint64 Code, int StartPos, int length, LatticeVector *ChainArray, OccupancyMap &Map)
+{
+/* Reconstruct The Free End of an Existing Chain Under a Change of Code, Check New Atoms for Overlaps
+   length Denotes Total Number of Segments
+   StartPos Denotes the First Segment to Be Rebuilt (atoms before StartPos must be marked, without overlaps)
+
+   Function Value Returned is the Position of the First Overlapping Atom (as for ChainOverlap)
+   Function Returns Zero Result If Chain Has No Overlaps
+   Note: The chain is not rebuilt beyond an overlapping atom. */
+
+/* *** Task #1:  Remove Atoms of the Old Tail From the Map */
+	for (; Map.Top >= StartPos; --Map.Top)  Map.Clear(ChainArray[Map.Top]);
+
+/* *** Task #2:  Find Orientation of Segment at Start of Rebuild Section */
+
+/* Orientation of Second Segment */
+	int orientation = 1;
+
+/* Prepare Comparison Code for Segment Analysis */
+	uint64 PositionCode = ((uint64)1 << (length - 2));
+
+	for (int k = 3; k < StartPos; ++k)
+	{
+	/* Select Next Bit for Comparison */
+		PositionCode >>= 1;
+
+	/* Calculate Orientation of Next Segment */
+		if ((Code & PositionCode) == 0)
+			++orientation;
+		else
+			--orientation;
+	}
+
+/* *** Task #3:  Reconstruct End of Chain, Atom by Atom */
+
+	for (int k = StartPos; k <= length; ++k)
+	{
+	/* Copy Current Lattice Position */
+		ChainArray[k] = ChainArray[k-1];
+
+	/* Select Next Bit for Comparison */
+		PositionCode >>= 1;
+
+	/* Select Segment, Calculate Next Lattice Position */
+		if ((Code & PositionCode) == 0)
+		{
+			ChainArray[k].LeftTurn(orientation);
+			++orientation;
+		}
+		else
+		{
+			ChainArray[k].RightTurn(orientation);
+			--orientation;
+		}
+
+		COUNT(++ThreadCounters.SegmentsRebuilt);
+
+	/* Site Taken Already?  Report Position */
+		if (Map.IsOccupied(ChainArray[k]))  return k;
+
+		Map.Set(ChainArray[k]);
+		Map.Top = k;
+	}
+
+/* No Overlap Found */
+	return 0;
+}
+
+inline bool ClosedLoopCheck (int length, LatticeVector *ChainArray)
 {
 /* A Simplified Closed Loop Check that Assumes that The Overlapping Atom is the Final Atom in the Chain */
 
 /* Check for Overlaps in Interior of Chain */
 	for (int k1 = length - 6; k1 > 0; --k1)
 	{
-		if (ChainArray[length] == ChainArray[k1]) return false;
+		if (ChainArray[length] == ChainArray[k1])
+		{
+			COUNT(++ThreadCounters.LoopsOpen);
+			return false;
+		}
 	}
 
 /* None Found, So the Loop Must Be Closed */
+	COUNT(++ThreadCounters.LoopsClosed);
 	return true;
 }
 
@@ -651,397 +1066,5487 @@ bool IsChainClosedLoop (int length, LatticeVector *ChainArray)
 	return true;
 }
 
-void PrintChainArray (int length, LatticeVector* ChainArray)
-{
-/* Print the Coordinates of the Atomic Grid Sites in the Chain */
+/* *** PACKED LATTICE SITES *** */
 
-	for(int i=0; i <= length; ++i){
-		cout << "(" << ChainArray[i].n1 << "," << ChainArray[i].n2 << "," << ChainArray[i].n3 << ") ";
-	}
-	cout << "\n";
-}
+/* Alternative lattice-step core for the distance check:  the three coordinates of an atom share a single word
+   (16-bit lanes, biased to stay positive), so that comparing two atoms takes a single compare, and a step along
+   a segment is a single addition of a displacement looked up by turn and orientation.  The orientation stays in
+   the range 0 ... 5 by a table of successor states, which replaces the modulo operation and the switch of
+   LeftTurn and RightTurn.  The SIMD variant (SSE2) finds the distances to eight earlier atoms at a time, and
+   then skips all atoms excluded by any of them. */
 
-double Duration (clock_t initial, clock_t final)
+/* Lane Units, Bias of Coordinates in Lanes (lane 3 is always zero) */
+const uint64 Lane1 = (uint64)1;
+const uint64 Lane2 = (uint64)1 << 16;
+const uint64 Lane3 = (uint64)1 << 32;
+const uint64 PackedBias = 0x4000 * (Lane1 + Lane2 + Lane3);
+
+/* Displacement by Turn (0: left, 1: right) and Orientation (as in LeftTurn, RightTurn) */
+const uint64 PackedStep[2][6] =
 {
-/* Determine the Duration of a Calculation in Seconds */
+	{0 - Lane3, Lane2, 0 - Lane1, Lane3, 0 - Lane2, Lane1},
+	{0 - Lane2, Lane1, 0 - Lane3, Lane2, 0 - Lane1, Lane3}
+};
+
+/* Orientation of Next Segment by Turn and Orientation */
+const int NextOrientation[2][6] =
+{
+	{1, 2, 3, 4, 5, 0},
+	{5, 0, 1, 2, 3, 4}
+};
 
-	double TimeDiff = (double)(final - initial);
-	return TimeDiff / CLOCKS_PER_SEC;
+inline uint64 PackSite (const LatticeVector &r)
+{
+/* Pack Coordinates of a Lattice Site Into a Single Word */
+	return PackedBias + (uint64)(int64)r.n1 * Lane1 + (uint64)(int64)r.n2 * Lane2 + (uint64)(int64)r.n3 * Lane3;
 }
 
-int _tmain(int argc, _TCHAR* argv[])
+inline int PackedDistance (uint64 Site1, uint64 Site2)
 {
-	int Length;
-	clock_t StartTime, FinishTime;
-	double StartToFinish;
+/* Distance (L1 norm) Between Two Packed Sites */
+	return abs((int)(Site1 & 0xFFFF) - (int)(Site2 & 0xFFFF))
+		 + abs((int)((Site1 >> 16) & 0xFFFF) - (int)((Site2 >> 16) & 0xFFFF))
+		 + abs((int)((Site1 >> 32) & 0xFFFF) - (int)((Site2 >> 32) & 0xFFFF));
+}
 
-/* Enter Maximum Chain Length Examined */
-	cout << "Enter Chain Length: ";
-	cin >> Length;
-	cout << "\n\n";
+inline int PackedOrientation (uint64 Code, int StartPos, int length)
+{
+/* Orientation of Segment StartPos (at least 3) in a Chain of length Segments (left turns minus right turns so far) */
+	int Turns = StartPos - 3;
+	int RightTurns = BitCount((Code >> (length - StartPos + 1)) & (((uint64)1 << Turns) - 1));
 
-/* Storage Array for Atom Coordinates */
-	LatticeVector *ChainArray = new LatticeVector [Length + 1];
+	int d = (1 + Turns - 2 * RightTurns) % 6;
+	if (d < 0) d += 6;
 
-/* Storage Array for Self-Avoiding Polygon Chains */
-/* (Estimate of number from exponential fit of known results) */
-	uint64 MaxPolygonNumber = 32 + (uint64)(0.005 * exp(0.574 * Length));
-	PolyMath *Polygon = new PolyMath [MaxPolygonNumber];
+	return d;
+}
 
-/* There are 2^(l-2) Different Chains */
-	uint64 MaxCode = ((uint64)1 << (Length - 2));
+inline void RebuildPackedChain (uint64 Code, int StartPos, int EndPos, int length, uint64 *Sites)
+{
+/* Reconstruct The Free End of a Packed Chain Under a Change of Code (see RebuildChain)
+   length Denotes Total Number of Segments
+   Segments StartPos (at least 3) ... EndPos Are Rebuilt */
 
-	int OverlapAt, Segment;
-	uint64 NonOverlaps = 0;
-	uint64 ClosedChains = 0;
+/* Atoms 0, 1, 2 Are Fixed:  Nothing to Rebuild in Chains of 2 Segments */
+	if (StartPos < 3)  StartPos = 3;
+	if (StartPos > EndPos)  return;
 
-/* Auxiliary Variables for Progress Report */
-	uint64 ChainChecks = 0;
-	uint64 ProgressMark = (uint64)(1 << 24) - 1;
+/* *** Task #1:  Orientation of Segment at Start of Rebuild Section */
+	int d = PackedOrientation(Code, StartPos, length);
 
-/* EXAMINE ALL CHAINS FOR OVERLAPS */
+/* *** Task #2:  Reconstruct End of Chain */
+	COUNT(ThreadCounters.SegmentsRebuilt += EndPos - StartPos + 1);
 
-/* Timing Support - Start of Calculation */
-	cout << "Calculating chains of length " << Length << " ... ";
-	StartTime = clock();
+	for (int k = StartPos; k <= EndPos; ++k)
+	{
+		int Turn = (int)((Code >> (length - k)) & 1);
 
-/* Build Initial Chain */
-	uint64 Code = 0;
-	BuildChain(Code, Length, ChainArray);
+		Sites[k] = Sites[k-1] + PackedStep[Turn][d];
+		d = NextOrientation[Turn][d];
+	}
+}
 
-/* Use Final Chain for Initial Comparison
-   (guarantees complete check of initial chain for overlaps) */
-	uint64 LastCode = MaxCode - 1;
+inline void BuildPackedChain (uint64 Code, int length, uint64 *Sites)
+{
+/* Build a Complete Packed Chain (same atoms as BuildChain) */
+	Sites[0] = PackSite(LatticeVector(0,0,0));
+	Sites[1] = PackSite(LatticeVector(1,0,0));
+	Sites[2] = PackSite(LatticeVector(1,0,-1));
 
-/* Loop Through Chains, Search for Overlaps and Closed Self-Avoiding Chains */
-	do
-	{
-	/* *** Task #1:  Progress Indicator, Check Counter */
+	RebuildPackedChain(Code, 3, length, length, Sites);
+}
 
-	/* Count Examined Chains: */
-		++ChainChecks;
+inline int PackedChainOverlap (int segment, int length, const uint64 *Sites)
+{
+/* Find the First Overlap of Two "Atoms" in a Packed Chain (see ChainOverlap)
+   Function Value Returned is the Position of the Overlapping Atom (zero: no overlaps) */
+
+	COUNT(++ThreadCounters.OverlapChecks);
+
+	for (int k1 = segment; k1 <= length ; ++k1)
+	{
+		int k2 = 0;
 
-	/* Progress Report after 2^24 (about 16 million) Evaluations */
-		if ((ChainChecks & ProgressMark) == 0)
+		while (k2 < k1 - 5)
 		{
-			cerr << 100 * ((float)Code)/MaxCode << "% done.\n";
+			int separation = PackedDistance(Sites[k1], Sites[k2]);
+			COUNT(++ThreadCounters.Distances);
+
+			if (separation == 0)  return k1;
+
+			k2 += separation;
 		}
+	}
 
-	/* *** Task #2:  Find Common Head of Old and New Chains, Rebuild Chain, Check for Overlaps */
+	return 0;
+}
 
-	/* Find Branching Segment */
-		Segment = BranchingSegment(Code, LastCode, Length);
+#if defined (HAS_SSE2)
 
-	/* Reconstruct Chain As Necessary */
-		RebuildChain(Code, Segment, Length, ChainArray);
+inline __m128i PackedDistancePair (__m128i Target, const uint64 *Sites)
+{
+/* Distances of Two Adjacent Packed Sites to a Target (in 32-bit lanes 0 and 1) */
+	__m128i Difference = _mm_sub_epi16(_mm_loadu_si128((const __m128i *)Sites), Target);
+	__m128i Magnitude = _mm_max_epi16(Difference, _mm_sub_epi16(_mm_setzero_si128(), Difference));
 
-	/* Test Chain For Overlaps: */
-		OverlapAt = ChainOverlap(Segment, Length, ChainArray);
+/* Add Lanes:  (|d1| + |d2|, |d3|) for Each Site, Then Both Halves */
+	__m128i Sums = _mm_madd_epi16(Magnitude, _mm_set1_epi16(1));
+	Sums = _mm_add_epi32(Sums, _mm_shuffle_epi32(Sums, _MM_SHUFFLE(2, 3, 0, 1)));
 
-	/* *** Task #3:  Intelligent Update of Chain Code, Jump Over Known "Bad" Chains */
+	return _mm_shuffle_epi32(Sums, _MM_SHUFFLE(3, 1, 2, 0));
+}
 
-	/* Remember Code Used */
-		LastCode = Code;
+inline int PackedChainOverlapSimd (int segment, int length, const uint64 *Sites)
+{
+/* Find the First Overlap of Two "Atoms" in a Packed Chain, Eight Distances at a Time
+   Function Value Returned is the Position of the Overlapping Atom (zero: no overlaps)
 
-	/* Analyze Result: No Overlap? */
-		if (OverlapAt == 0)
-		{
-			++NonOverlaps;
-			++Code;
-		}
-		else
+   Method: Atom k2 + j at distance s from the target excludes atoms k2 + j ... k2 + j + s - 1, so that after
+   eight distances without overlap, the search continues at the end of the longest exclusion. */
+
+	COUNT(++ThreadCounters.OverlapChecks);
+
+	for (int k1 = segment; k1 <= length ; ++k1)
+	{
+		__m128i Target = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)&Sites[k1]), _mm_loadl_epi64((const __m128i *)&Sites[k1]));
+
+		int k2 = 0;
+
+		while (k2 + 8 <= k1 - 5)
 		{
-		/* Analyze Result: Closed Non-Overlapping Chain? */
-			if (OverlapAt == Length)
+		/* Distances to Atoms k2 ... k2 + 7 */
+			__m128i Low = _mm_unpacklo_epi64(PackedDistancePair(Target, &Sites[k2]), PackedDistancePair(Target, &Sites[k2 + 2]));
+			__m128i High = _mm_unpacklo_epi64(PackedDistancePair(Target, &Sites[k2 + 4]), PackedDistancePair(Target, &Sites[k2 + 6]));
+			COUNT(ThreadCounters.Distances += 8);
+
+			__m128i Zero = _mm_setzero_si128();
+			if (_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi32(Low, Zero), _mm_cmpeq_epi32(High, Zero))) != 0)  return k1;
+
+		/* Skip to End of Longest Exclusion */
+			int Separation[8];
+			_mm_storeu_si128((__m128i *)&Separation[0], Low);
+			_mm_storeu_si128((__m128i *)&Separation[4], High);
+
+			int Skip = 8;
+			for (int j = 0; j < 8; ++j)
 			{
-				if (ClosedLoopCheck(Length, ChainArray) == true)
-				{
-					Polygon[ClosedChains] = PolyMath(Code, Length);
-					++ClosedChains;
-				}
+				if (j + Separation[j] > Skip)  Skip = j + Separation[j];
 			}
 
-		/* Perform "Smart Jump" to Next Code Without This Overlap */
-
-		/* Remove Trailing End of Code */
-			Code >>= (Length - OverlapAt);
-		/* Step to Next Chain Segment Without This Specific Overlap */
-			++Code;
-		/* Fill Chain with Left Turns:  Lowest Value of Code Without Offending Overlap */
-			Code <<= (Length - OverlapAt);
+			k2 += Skip;
 		}
-	}
-	while (Code < MaxCode);
 
-/* Timing Support - End of Calculation */
-	FinishTime = clock();
-	StartToFinish = Duration(StartTime, FinishTime);
+	/* Remaining Atoms One at a Time */
+		while (k2 < k1 - 5)
+		{
+			int separation = PackedDistance(Sites[k1], Sites[k2]);
+			COUNT(++ThreadCounters.Distances);
 
-/* Send a Brief Message */
-	cout << " done! \n\n";
-	cout << "(Evaluations performed: " << ChainChecks << " out of " << MaxCode << " in " << StartToFinish << " seconds) \n\n";
+			if (separation == 0)  return k1;
 
-/* SORT OUT SELF-AVOIDING POLYGONS */
+			k2 += separation;
+		}
+	}
 
-/* Timing Support - Start of Calculation */
-	cout << "Now Examining " << ClosedChains << " Self-Avoiding Polygons ... \n\n";
-	StartTime = clock();
+	return 0;
+}
 
-/* *** Step #1:  Find & Replace Reduced Polygon Codes */
-	cout << "Reduce to Primitives ... ";
+#endif
 
-	for (uint64 i = 0; i < ClosedChains; ++i)
+inline bool PackedClosedLoopCheck (int length, const uint64 *Sites)
+{
+/* A Simplified Closed Loop Check that Assumes that The Overlapping Atom is the Final Atom in the Chain */
+	for (int k1 = length - 6; k1 > 0; --k1)
 	{
-		Polygon[i].Reduce();
+		if (Sites[length] == Sites[k1])
+		{
+			COUNT(++ThreadCounters.LoopsOpen);
+			return false;
+		}
 	}
 
-	cout << "done.\n";
-
-/* *** Step #2:  Sort List of Primitives (using a fast merge-sort algorithm) */
-	cout << "Sort List of Primitives ... ";
+	COUNT(++ThreadCounters.LoopsClosed);
+	return true;
+}
 
-/* Create Array for Polygon Codes */
-	uint64 *CodeArray = new uint64[ClosedChains];
+void PrintChainArray (int length, LatticeVector* ChainArray)
+{
+/* Print the Coordinates of the Atomic Grid Sites in the Chain */
 
-/* Copy Polygon Codes Into Code Array */
-	for (uint64 i = 0; i < ClosedChains; ++i)
-	{
-		CodeArray[i] = Polygon[i].Code;
+	for(int i=0; i <= length; ++i){
+		cout << "(" << ChainArray[i].n1 << "," << ChainArray[i].n2 << "," << ChainArray[i].n3 << ") ";
 	}
+	cout << "\n";
+}
 
-/* Get Rid of the Original Polygon Array */
-	delete[] Polygon;
-
-/* Create Temporary Array for Sort */
-	uint64 *WorkArray = new uint64[ClosedChains];
+/* Points in Time of the Steady Clock (wall time, also correct for several threads) */
+typedef std::chrono::steady_clock::time_point TimePoint;
 
-/* Outer Sort Loop:  Double Sub-Arrays To Be Sorted by Factor of 2 in Each Run*/
-	for (uint64 ArraySize = 1; ArraySize <= ClosedChains; ArraySize <<= 1)
-	{
-	/* Select Adjacent Sub-Arrays for Comparison Sort */
-		for (uint64 ArrayCount = 0; ArrayCount < ClosedChains; ArrayCount += 2 * ArraySize)
-		{
-		/* Compare Primitives in Sub-Arrays */
+inline TimePoint Now ()
+{
+	return std::chrono::steady_clock::now();
+}
 
-		/* Bounds in Work Array */
-			uint64 WorkCtr = ArrayCount;
-			uint64 WorkCtrMax = ArrayCount + 2 * ArraySize;
-			if (WorkCtrMax > ClosedChains)  WorkCtrMax = ClosedChains;
+double Duration (TimePoint initial, TimePoint final)
+{
+/* Determine the Duration of a Calculation in Seconds */
 
-		/* Starting Pointers in Code Array */
-			uint64 ArrayCtr1 = ArrayCount;
-			uint64 ArrayCtr1Max = ArrayCount + ArraySize;
-			if (ArrayCtr1Max > ClosedChains)  ArrayCtr1Max = ClosedChains;
+	return std::chrono::duration<double>(final - initial).count();
+}
 
-			uint64 ArrayCtr2 = ArrayCtr1Max;
+/* *** POLYGON CATALOG FILES *** */
 
-		/* Do the Sort */
-			do
-			{
-				if (ArrayCtr1 < ArrayCtr1Max)
-				{
-				/* Sub-Array #1 Has Elements Available */
-					uint64 Code1 = CodeArray[ArrayCtr1];
+/* A catalog keeps the unique primitive polygons of one length for later analysis.  The codes are stored in
+   ascending order, each one as the difference to the code before it, in 7-bit groups (lowest group first, high
+   bit set on all groups but the last).  Every CatalogBlockSize entries, a new block starts with the complete
+   code, and a block index records its first code and byte offset, so that readers may start anywhere.  An
+   optional array holds one byte per polygon with its symmetry class (0 ... 7 in the order of the census).
 
-					if (ArrayCtr2 < WorkCtrMax)
-					{
-					/* Sub-Array #2 Has Elements Available */
-						uint64 Code2 = CodeArray[ArrayCtr2];
+   Layout:  header | encoded codes (padded to 8 bytes) | block index | symmetry bytes (optional)
 
-						if (Code1 < Code2)
-						{
-						/* Comparison of Sub-Array Elements */
-							WorkArray[WorkCtr] = Code1;
+   The reader maps the file into memory and decodes the codes in place, without copies; the lattice sites of
+   a polygon are rebuilt on demand by BuildChain. */
 
-						/* Increment Counter in First Sub-Array */
-							++ArrayCtr1;
-						}
-						else
-						{
-						/* Select Element From Second Sub-Array */
-							WorkArray[WorkCtr] = Code2;
+/* File Identification, Entries per Block */
+const char CatalogMagic[8] = {'2', 'D', 'C', 'A', 'T', 'L', 'G', '1'};
+const uint64 CatalogBlockSize = 4096;
 
-						/* Increment Counter in Second Sub-Array */
-							++ArrayCtr2;
-						}
-					}
-					else
-					{
-					/* Select Element From First Sub-Array By Default */
-						WorkArray[WorkCtr] = Code1;
+/* Flags of Catalogs */
+const uint64 CatalogHasSymmetry = 1;
 
-					/* Increment Counter in First Sub-Array */
-						++ArrayCtr1;
-					}
-				}
-				else
-				{
-				/* Select Element From Second Sub-Array By Default */
-					WorkArray[WorkCtr] = CodeArray[ArrayCtr2];
+struct CatalogHeader
+{
+/* Head of a Catalog File (offsets in bytes from the start of the file) */
+	char Magic[8];
+	uint64 Length;
+	uint64 Count;
+	uint64 Flags;
+	uint64 BlockSize;
+	uint64 DataOffset;
+	uint64 DataBytes;
+	uint64 IndexOffset;
+	uint64 SymmetryOffset;
+
+/* Census of Symmetry Classes */
+	uint64 Classes[8];
+};
 
-				/* Increment Counter in Second Sub-Array */
-					++ArrayCtr2;
-				}
+struct CatalogBlock
+{
+/* Entry of the Block Index */
+	uint64 FirstCode;
+	uint64 Offset;
+};
 
-			/* Increase Work Counter */
-				++WorkCtr;
-			}
-			while (WorkCtr < WorkCtrMax);
-		}
+class CatalogWriter
+{
+/* Writes a Catalog From Unique Primitive Codes Passed in Ascending Order */
+public:
+	CatalogWriter ()
+	{
+	/* Default Constructor:  No File */
+		File = NULL;
+		IsFailed = false;
+	}
 
-	/* Copy the Work Array Back Into the Code Array */
-		for (uint64 i = 0; i < ClosedChains; ++i)
-		{
-			CodeArray[i] = WorkArray[i];
-		}
+	~CatalogWriter ()
+	{
+		if (File != NULL)  fclose(File);
 	}
 
-	cout << "done.\n";
+	bool Open (const _TCHAR *FileName, int Length, bool WithSymmetry)
+	{
+	/* Create File, Leave Room for Header */
+		File = _tfopen(FileName, _T("wb"));
+		if (File == NULL)  return false;
 
-/* *** Step #3: Eliminate Duplicates From List */
-	cout << "Eliminate Duplicates ... ";
+		memset(&Header, 0, sizeof(Header));
+		memcpy(Header.Magic, CatalogMagic, sizeof(CatalogMagic));
+		Header.Length = Length;
+		Header.Flags = WithSymmetry ? CatalogHasSymmetry : 0;
+		Header.BlockSize = CatalogBlockSize;
+		Header.DataOffset = sizeof(CatalogHeader);
 
-/* Counter for Unique Polygons (up to reflections) */
-	uint64 UniquePolygons = 0;
+		PreviousCode = 0;
+		IsFailed = (fwrite(&Header, sizeof(Header), 1, File) != 1);
 
-/* Choic Guarantees First Polygon To Be Considered Unique */
-	uint64 PreviousCode = ClosedChains;
+		return !IsFailed;
+	}
 
-/* Collect Unique Polygons */
-	for (uint64 i = 0; i < ClosedChains; ++i)
+	void Append (uint64 Code, int Class)
 	{
-		if (CodeArray[i] != LastCode)
+	/* Add the Next Polygon (codes strictly ascending) */
+		uint64 Value = Code - PreviousCode;
+
+		if ((Header.Count % CatalogBlockSize) == 0)
 		{
-		/* Found a New Type of Polygon */
-			LastCode = CodeArray[i];
+		/* New Block:  Complete Code */
+			CatalogBlock Block = {Code, Header.DataBytes};
+			Index.push_back(Block);
+			Value = Code;
+		}
 
-			WorkArray[UniquePolygons] = LastCode;
+	/* Encode in 7-Bit Groups */
+		unsigned char Bytes[10];
+		int n = 0;
 
-			++UniquePolygons;
+		while (Value >= 0x80)
+		{
+			Bytes[n++] = (unsigned char)(Value | 0x80);
+			Value >>= 7;
 		}
-	}
+		Bytes[n++] = (unsigned char)Value;
 
-/* Get Rid of the Code Array */
-	delete[] CodeArray;
+		if (fwrite(Bytes, 1, n, File) != (size_t)n)  IsFailed = true;
 
-/* Re-Build Array for Unique Polygon Codes */
-	PolyMath *PrimitivePolygon = new PolyMath [UniquePolygons];
+		if ((Header.Flags & CatalogHasSymmetry) != 0)  Symmetry.push_back((unsigned char)Class);
 
-/* Copy Results Back Into Polygon Array */
-	for (uint64 i = 0; i < UniquePolygons; ++i)
-	{
-		PrimitivePolygon[i] = PolyMath(WorkArray[i], Length);
+		Header.DataBytes += n;
+		++Header.Count;
+		PreviousCode = Code;
 	}
 
-/* Memory Clean-Up */
-	delete[] WorkArray;
+	bool Close (const SymmetryCensus &Census)
+	{
+	/* Write Padding, Block Index, Symmetry Bytes, Then Complete Header (function value:  file written) */
+		if (File == NULL)  return false;
 
-	cout << "done.\n";
+		static const char Padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+		size_t PaddingBytes = (size_t)((8 - (Header.DataBytes & 7)) & 7);
+		if (fwrite(Padding, 1, PaddingBytes, File) != PaddingBytes)  IsFailed = true;
 
-/* Step #4:  Examine Symmetry Properties of Chains */
-/* (Note:  Possibilities are 1, 2, 3, 6-fold rotational symmetry, perhaps with additional mirror symmetry.) */
-	cout << "Examine Symmetry Properties ... ";
+		Header.IndexOffset = Header.DataOffset + Header.DataBytes + PaddingBytes;
+		if (!Index.empty() && (fwrite(Index.data(), sizeof(CatalogBlock), Index.size(), File) != Index.size()))  IsFailed = true;
 
-/* Set Up Counters For Symmetry Classes */
-	uint64 SC1 = 0;
-	uint64 SC1m = 0;
-	uint64 SC2 = 0;
-	uint64 SC2m = 0;
-	uint64 SC3 = 0;
-	uint64 SC3m = 0;
-	uint64 SC6 = 0;
-	uint64 SC6m = 0;
+		Header.SymmetryOffset = Header.IndexOffset + Index.size() * sizeof(CatalogBlock);
+		if (!Symmetry.empty() && (fwrite(Symmetry.data(), 1, Symmetry.size(), File) != Symmetry.size()))  IsFailed = true;
 
-/* Analyze Primitive Polygons */
-	for (uint64 i = 0; i < UniquePolygons; ++i)
+		uint64 Classes[8] = {Census.SC1, Census.SC1m, Census.SC2, Census.SC2m, Census.SC3, Census.SC3m, Census.SC6, Census.SC6m};
+		memcpy(Header.Classes, Classes, sizeof(Classes));
+
+		if ((fseek(File, 0, SEEK_SET) != 0) || (fwrite(&Header, sizeof(Header), 1, File) != 1))  IsFailed = true;
+		if ((ferror(File) != 0) | (fclose(File) != 0))  IsFailed = true;
+
+		File = NULL;
+		return !IsFailed;
+	}
+
+	uint64 Count (void) const
 	{
-	/* Analyze for Rotational and Mirror Symmetry */
-		int RotSym = PrimitivePolygon[i].RotationalSymmetry();
-		bool MirrSymm = PrimitivePolygon[i].MirrorSymmetry();
+		return Header.Count;
+	}
 
-	/* Count Occurrences */
-		if (MirrSymm == true)
+private:
+	FILE *File;
+	CatalogHeader Header;
+	std::vector<CatalogBlock> Index;
+	std::vector<unsigned char> Symmetry;
+	uint64 PreviousCode;
+	bool IsFailed;
+};
+
+class CatalogReader
+{
+/* Zero-Copy Access to a Catalog File Mapped Into Memory */
+public:
+	const CatalogHeader *Header;
+
+	class Cursor
+	{
+	/* Position in the Catalog:  Decodes One Polygon After the Other, Starting Anywhere */
+	public:
+		bool Next (uint64 &Code)
 		{
-		/* Symmetry Classes With Mirror Symmetry */
-			switch (RotSym)
+		/* Code of the Next Polygon (function value:  false at the end of the catalog, or if the data are damaged) */
+			if (Entry >= Catalog->Header->Count)  return false;
+
+			uint64 Value = 0;
+			int Shift = 0;
+
+			for (;;)
 			{
-			case 1:
-				++SC1m;
-				break;
-			case 2:
-				++SC2m;
-				break;
-			case 3:
-				++SC3m;
-				break;
-			case 6:
-				++SC6m;
-				break;
-			default:
-				break;
+			/* Damaged Data:  Code Runs Past the Data, or Longer Than 64 Bits (stay at the end) */
+				if ((Position >= End) || (Shift >= 64))
+				{
+					Position = End;
+					return false;
+				}
+
+				unsigned char Byte = *Position++;
+				Value |= (uint64)(Byte & 0x7F) << Shift;
+				if ((Byte & 0x80) == 0)  break;
+				Shift += 7;
 			}
+
+			Code = ((Entry % CatalogBlockSize) == 0) ? Value : Previous + Value;
+			Previous = Code;
+			++Entry;
+
+			return true;
 		}
-		else
+
+		uint64 Number (void) const
 		{
-		/* Symmetry Classes Without Mirror Symmetry */
-			switch (RotSym)
-			{
-			case 1:
-				++SC1;
-				break;
-			case 2:
-				++SC2;
-				break;
-			case 3:
-				++SC3;
-				break;
-			case 6:
-				++SC6;
-				break;
-			default:
-				break;
-			}
+		/* Number of the Next Polygon */
+			return Entry;
 		}
-	}
 
-	cout << "done.\n\n";
+	private:
+		friend class CatalogReader;
 
-/* Timing Support - End of Calculation */
-	FinishTime = clock();
-	StartToFinish = Duration(StartTime, FinishTime);
+		const CatalogReader *Catalog;
+		const unsigned char *Position;
+		const unsigned char *End;
+		uint64 Entry;
+		uint64 Previous;
+	};
 
-/* Send a Brief Message */
-	cout << "(Found " << UniquePolygons << " unique self-avoiding polygon(s) in " << StartToFinish << " seconds) \n\n";
+	CatalogReader ()
+	{
+	/* Default Constructor:  No File */
+		Header = NULL;
+		Base = NULL;
+		Size = 0;
+	}
 
-/* For Now, Just Report Results: */
+	~CatalogReader ()
+	{
+		Close();
+	}
 
-/* Display Final Results */
-	cout << "\n *** RESULTS for Chains on 2D Honeycomb Lattice with " << Length << " Segments:\n\n";
+	bool Open (const _TCHAR *FileName)
+	{
+	/* Map Catalog Into Memory, Check Its Layout (function value:  catalog usable) */
+		Close();
 
-/* Number of Non-Overlapping Chains */
-	cout << "Number of Non-Overlapping Chains: " << NonOverlaps << "\n\n";
+#if defined (_WIN32)
+		HANDLE File = CreateFile(FileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (File == INVALID_HANDLE_VALUE)  return false;
 
-/* Number of Closed-Loop Chains */
-	cout << "Number of Closed-Loop Chains: " << ClosedChains << "\n\n";
+		LARGE_INTEGER FileSize;
+		if (GetFileSizeEx(File, &FileSize) && (FileSize.QuadPart >= (LONGLONG)sizeof(CatalogHeader)))
+		{
+			HANDLE Mapping = CreateFileMapping(File, NULL, PAGE_READONLY, 0, 0, NULL);
 
-/* Number of Unique Polygons */
-	cout << "Number of Unique Polygons: " << UniquePolygons << " (includes mirror symmetric pairs)\n\n";
+			if (Mapping != NULL)
+			{
+				Base = (const unsigned char *)MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+				Size = (uint64)FileSize.QuadPart;
+				CloseHandle(Mapping);
+			}
+		}
+		CloseHandle(File);
+#else
+		int File = open(FileName, O_RDONLY);
+		if (File < 0)  return false;
+
+		struct stat Status;
+		if ((fstat(File, &Status) == 0) && ((uint64)Status.st_size >= sizeof(CatalogHeader)))
+		{
+			void *Mapping = mmap(NULL, (size_t)Status.st_size, PROT_READ, MAP_SHARED, File, 0);
+
+			if (Mapping != MAP_FAILED)
+			{
+				Base = (const unsigned char *)Mapping;
+				Size = (uint64)Status.st_size;
+			}
+		}
+		close(File);
+#endif
+
+		if (Base == NULL)  return false;
+
+	/* Check Identification and Bounds of All Parts */
+		const CatalogHeader *Head = (const CatalogHeader *)Base;
+		uint64 Blocks = (Head->Count + CatalogBlockSize - 1) / CatalogBlockSize;
+		uint64 SymmetryBytes = ((Head->Flags & CatalogHasSymmetry) != 0) ? Head->Count : 0;
+
+		bool IsValid = (memcmp(Head->Magic, CatalogMagic, sizeof(CatalogMagic)) == 0)
+					   && (Head->Length >= 3) && (Head->Length <= 63) && (Head->BlockSize == CatalogBlockSize)
+					   && (Head->DataOffset == sizeof(CatalogHeader)) && (Head->DataBytes <= Size - Head->DataOffset)
+					   && (Head->IndexOffset >= Head->DataOffset + Head->DataBytes) && ((Head->IndexOffset & 7) == 0)
+					   && (Head->IndexOffset <= Size) && (Blocks <= (Size - Head->IndexOffset) / sizeof(CatalogBlock))
+					   && (Head->SymmetryOffset == Head->IndexOffset + Blocks * sizeof(CatalogBlock))
+					   && (SymmetryBytes <= Size - Head->SymmetryOffset);
+
+	/* Block Index:  First Block at the Start of the Data, Offsets Ascending, All Within the Data */
+		if (IsValid)
+		{
+			const CatalogBlock *Index = (const CatalogBlock *)(Base + Head->IndexOffset);
+
+			for (uint64 b = 0; b < Blocks; ++b)
+			{
+				if ((b == 0) ? (Index[b].Offset != 0) : (Index[b].Offset <= Index[b - 1].Offset))  IsValid = false;
+				if (Index[b].Offset >= Head->DataBytes)  IsValid = false;
+			}
+		}
+
+		if (!IsValid)
+		{
+			Close();
+			return false;
+		}
+
+		Header = Head;
+		return true;
+	}
+
+	void Close (void)
+	{
+	/* Release Mapping */
+		if (Base != NULL)
+		{
+#if defined (_WIN32)
+			UnmapViewOfFile(Base);
+#else
+			munmap((void *)Base, (size_t)Size);
+#endif
+		}
+
+		Header = NULL;
+		Base = NULL;
+		Size = 0;
+	}
+
+	int Length (void) const
+	{
+		return (int)Header->Length;
+	}
+
+	uint64 Count (void) const
+	{
+		return Header->Count;
+	}
+
+	bool HasSymmetry (void) const
+	{
+		return (Header->Flags & CatalogHasSymmetry) != 0;
+	}
+
+	Cursor At (uint64 Entry) const
+	{
+	/* Cursor Placed on Polygon Number Entry (decodes from the start of its block) */
+		if (Entry > Header->Count)  Entry = Header->Count;
+
+		const CatalogBlock *Index = (const CatalogBlock *)(Base + Header->IndexOffset);
+		uint64 Block = Entry / CatalogBlockSize;
+
+		Cursor Place;
+		Place.Catalog = this;
+		Place.Position = Base + Header->DataOffset + ((Entry < Header->Count) ? Index[Block].Offset : Header->DataBytes);
+		Place.End = Base + Header->DataOffset + Header->DataBytes;
+		Place.Entry = (Entry < Header->Count) ? Block * CatalogBlockSize : Entry;
+		Place.Previous = 0;
+
+		uint64 Code;
+		while ((Place.Entry < Entry) && Place.Next(Code))  ;
+
+		return Place;
+	}
+
+	Cursor Begin (void) const
+	{
+		return At(0);
+	}
+
+	int Class (uint64 Entry) const
+	{
+	/* Symmetry Class of Polygon Number Entry (-1: not recorded) */
+		if (!HasSymmetry() || (Entry >= Header->Count))  return -1;
+
+		return Base[Header->SymmetryOffset + Entry];
+	}
+
+	bool Find (uint64 Code, uint64 &Entry) const
+	{
+	/* Look Up a Primitive Code:  Binary Search in Block Index, Then Decode Within Block */
+		const CatalogBlock *Index = (const CatalogBlock *)(Base + Header->IndexOffset);
+		uint64 Blocks = (Header->Count + CatalogBlockSize - 1) / CatalogBlockSize;
+
+		uint64 Low = 0, High = Blocks;
+		while (High - Low > 1)
+		{
+			uint64 Middle = (Low + High) / 2;
+			if (Index[Middle].FirstCode <= Code)  Low = Middle;  else  High = Middle;
+		}
+
+		Cursor Place = At(Low * CatalogBlockSize);
+		uint64 Candidate;
+
+		while ((Place.Number() < (Low + 1) * CatalogBlockSize) && Place.Next(Candidate))
+		{
+			if (Candidate == Code)
+			{
+				Entry = Place.Number() - 1;
+				return true;
+			}
+			if (Candidate > Code)  break;
+		}
+
+		return false;
+	}
+
+	void BuildPolygon (uint64 Code, LatticeVector *ChainArray) const
+	{
+	/* Lattice Sites of a Polygon (atoms 0 ... Length, last atom back at the origin)
+	   Primitive Codes Start With a Left Turn, Like All Chains:  Drop the Final Turn */
+		BuildChain(Code >> 1, Length(), ChainArray);
+	}
+
+private:
+	const unsigned char *Base;
+	uint64 Size;
+};
+
+bool VerifyCatalog (const CatalogReader &Catalog, SymmetryCensus &Census)
+{
+/* Read a Complete Catalog:  Codes Ascending, Every Polygon Closed, Symmetry Classes and Census As Recorded
+   Function Value Returned is true If All Checks Pass; Census of the Polygons Found */
+	int Length = Catalog.Length();
+	std::vector<LatticeVector> ChainArray(Length + 1);
+
+	CatalogReader::Cursor Place = Catalog.Begin();
+	uint64 Code = 0, PreviousCode = 0;
+	bool IsValid = true;
+
+	while (Place.Next(Code))
+	{
+		uint64 Entry = Place.Number() - 1;
+		if ((Entry > 0) && (Code <= PreviousCode))  IsValid = false;
+		PreviousCode = Code;
+
+	/* Chain Must Return to the Origin */
+		Catalog.BuildPolygon(Code, ChainArray.data());
+		if (!(ChainArray[Length] == ChainArray[0]))  IsValid = false;
+
+		PolyMath Primitive;
+		Primitive.Code = Code;
+		Primitive.Length = Length;
+
+		int Class = Census.Add(Primitive);
+		if (Catalog.HasSymmetry() && (Class != Catalog.Class(Entry)))  IsValid = false;
+	}
+
+	uint64 Classes[8] = {Census.SC1, Census.SC1m, Census.SC2, Census.SC2m, Census.SC3, Census.SC3m, Census.SC6, Census.SC6m};
+
+	if (Place.Number() != Catalog.Count())  IsValid = false;
+	if (memcmp(Classes, Catalog.Header->Classes, sizeof(Classes)) != 0)  IsValid = false;
+
+	return IsValid;
+}
+
+/* *** STORAGE FOR POLYGON CODES *** */
+
+class CodeArena
+{
+/* Growable Storage for Polygon Codes
+   Codes are kept in large pages that are allocated on demand and never moved, so that several threads
+   can append concurrently.  Only the 64-bit code is stored; the length is the same for all entries. */
+public:
+	static const int PageBits = 20;
+	static const uint64 PageSize = ((uint64)1 << PageBits);
+	static const size_t MaxPages = ((size_t)1 << 16);
+
+	std::atomic<uint64 *> *Pages;
+	std::atomic<uint64> Count;
+
+/* Memory Footprint */
+	std::mutex GrowLock;
+	uint64 AllocatedBytes;
+	uint64 PeakBytes;
+
+	CodeArena ()
+	{
+	/* Default Constructor:  Empty Page Directory */
+		Pages = new std::atomic<uint64 *> [MaxPages];
+		for (size_t i = 0; i < MaxPages; ++i)  Pages[i] = NULL;
+
+		Count = 0;
+		AllocatedBytes = MaxPages * sizeof(uint64 *);
+		PeakBytes = AllocatedBytes;
+	}
+
+	~CodeArena ()
+	{
+		Release();
+		delete[] Pages;
+	}
+
+	inline void Append (uint64 Code)
+	{
+	/* Store a Code (safe for concurrent use) */
+		uint64 Slot = Count++;
+		size_t Page = (size_t)(Slot >> PageBits);
+
+		uint64 *Target = Pages[Page].load(std::memory_order_acquire);
+		if (Target == NULL)  Target = AllocatePage(Page);
+
+		Target[Slot & (PageSize - 1)] = Code;
+	}
+
+	inline uint64 &operator [] (uint64 i)
+	{
+	/* Access to Stored Codes (after all threads are done appending) */
+		return Pages[(size_t)(i >> PageBits)].load(std::memory_order_relaxed)[i & (PageSize - 1)];
+	}
+
+	void ReleasePage (size_t Page)
+	{
+	/* Return a Single Page to the System (safe for concurrent use) */
+		uint64 *Target = Pages[Page].exchange(NULL);
+
+		if (Target != NULL)
+		{
+			delete[] Target;
+
+			std::lock_guard<std::mutex> Guard(GrowLock);
+			AllocatedBytes -= PageSize * sizeof(uint64);
+		}
+	}
+
+	void Release (void)
+	{
+	/* Return All Pages to the System */
+		for (size_t Page = 0; Page < MaxPages; ++Page)  ReleasePage(Page);
+	}
+
+private:
+	uint64 *AllocatePage (size_t Page)
+	{
+	/* Allocate Missing Page (only once, if several threads get here at the same time) */
+		std::lock_guard<std::mutex> Guard(GrowLock);
+
+		if (Page >= MaxPages)
+		{
+			cerr << "ERROR:  Polygon storage exhausted\n";
+			exit(1);
+		}
+
+		uint64 *Target = Pages[Page].load(std::memory_order_acquire);
+
+		if (Target == NULL)
+		{
+			Target = new uint64 [(size_t)PageSize];
+			Pages[Page].store(Target, std::memory_order_release);
+
+			AllocatedBytes += PageSize * sizeof(uint64);
+			if (AllocatedBytes > PeakBytes)  PeakBytes = AllocatedBytes;
+		}
+
+		return Target;
+	}
+};
+
+class PolygonHashSet
+{
+/* Set of Unique Primitive Polygon Codes, Filled by Several Threads During the Enumeration
+   The set is split into shards by the leading bits of a hash value.  Each shard is an open-addressing
+   table with linear probing, protected by its own lock and resized on its own, so that threads rarely
+   have to wait for each other. */
+public:
+	static const int ShardBits = 8;
+	static const int NumberOfShards = (1 << ShardBits);
+
+/* Marks Unused Slots (polygon codes have less than 64 bits) */
+	static const uint64 EmptySlot = ~(uint64)0;
+
+	struct Shard
+	{
+		std::mutex Lock;
+		uint64 *Slots;
+		uint64 Capacity;
+		uint64 Count;
+	};
+
+	Shard *Shards;
+
+	PolygonHashSet ()
+	{
+	/* Default Constructor:  Small Empty Tables */
+		Shards = new Shard [NumberOfShards];
+
+		for (int i = 0; i < NumberOfShards; ++i)
+		{
+			Shards[i].Capacity = 64;
+			Shards[i].Count = 0;
+			Shards[i].Slots = new uint64 [(size_t)Shards[i].Capacity];
+			for (uint64 j = 0; j < Shards[i].Capacity; ++j)  Shards[i].Slots[j] = EmptySlot;
+		}
+	}
+
+	~PolygonHashSet ()
+	{
+		for (int i = 0; i < NumberOfShards; ++i)  delete[] Shards[i].Slots;
+		delete[] Shards;
+	}
+
+	static inline uint64 Hash (uint64 Code)
+	{
+	/* Fibonacci Hashing:  Leading Bits Select Shard, Following Bits Select Slot */
+		return Code * (uint64)0x9E3779B97F4A7C15ULL;
+	}
+
+	bool Insert (uint64 Code)
+	{
+	/* Add a Primitive Code; Returns true If It Was Not Yet in the Set */
+		uint64 HashValue = Hash(Code);
+		Shard &Target = Shards[HashValue >> (64 - ShardBits)];
+
+		std::lock_guard<std::mutex> Guard(Target.Lock);
+
+		if (!Place(Target.Slots, Target.Capacity, HashValue, Code))  return false;
+
+	/* Keep Load Factor Below 1/2 */
+		if (2 * (++Target.Count) > Target.Capacity)  Grow(Target);
+
+		return true;
+	}
+
+	uint64 Count (void)
+	{
+	/* Number of Codes in Set (after all threads are done inserting) */
+		uint64 Total = 0;
+		for (int i = 0; i < NumberOfShards; ++i)  Total += Shards[i].Count;
+		return Total;
+	}
+
+	uint64 Bytes (void)
+	{
+	/* Memory Used by the Tables */
+		uint64 Total = 0;
+		for (int i = 0; i < NumberOfShards; ++i)  Total += Shards[i].Capacity * sizeof(uint64);
+		return Total;
+	}
+
+private:
+	static bool Place (uint64 *Slots, uint64 Capacity, uint64 HashValue, uint64 Code)
+	{
+	/* Linear Probing From Home Slot; Returns false If Code Is Already Present */
+		uint64 Mask = Capacity - 1;
+		uint64 Slot = (HashValue >> ShardBits) & Mask;
+
+		while (Slots[Slot] != EmptySlot)
+		{
+			if (Slots[Slot] == Code)  return false;
+			Slot = (Slot + 1) & Mask;
+		}
+
+		Slots[Slot] = Code;
+		return true;
+	}
+
+	static void Grow (Shard &Target)
+	{
+	/* Double Table Size, Re-Insert All Codes */
+		uint64 NewCapacity = 2 * Target.Capacity;
+		uint64 *NewSlots = new uint64 [(size_t)NewCapacity];
+		for (uint64 j = 0; j < NewCapacity; ++j)  NewSlots[j] = EmptySlot;
+
+		for (uint64 j = 0; j < Target.Capacity; ++j)
+		{
+			if (Target.Slots[j] != EmptySlot)  Place(NewSlots, NewCapacity, Hash(Target.Slots[j]), Target.Slots[j]);
+		}
+
+		delete[] Target.Slots;
+		Target.Slots = NewSlots;
+		Target.Capacity = NewCapacity;
+	}
+};
+
+/* Ways to Keep the Closed Polygons Found During the Enumeration */
+enum PolygonStorage
+{
+	StoreInMemory = 0,	/* all closed chains, sorted afterwards */
+	StoreInRuns = 1,	/* primitive codes in sorted runs on disk (streaming mode) */
+	StoreInHashSet = 2	/* unique primitive codes only */
+};
+
+uint64 CensusOfHashSet (PolygonHashSet &Set, int Length, SymmetryCensus &Census, CatalogWriter *Catalog)
+{
+/* Examine Symmetry Properties of All Unique Polygons in Hash Set, Add Them to Catalog (may be NULL)
+   Function Value Returned is the Number of Unique Polygons */
+
+	cout << "Examine Symmetry Properties ... ";
+
+	PolyMath Primitive;
+	Primitive.Length = Length;
+
+	if (Catalog != NULL)
+	{
+	/* Catalog Needs Ascending Codes:  Collect and Sort Them First */
+		std::vector<uint64> Codes;
+		Codes.reserve((size_t)Set.Count());
+
+		for (int i = 0; i < PolygonHashSet::NumberOfShards; ++i)
+		{
+			PolygonHashSet::Shard &Source = Set.Shards[i];
+
+			for (uint64 j = 0; j < Source.Capacity; ++j)
+			{
+				if (Source.Slots[j] != PolygonHashSet::EmptySlot)  Codes.push_back(Source.Slots[j]);
+			}
+		}
+
+		std::sort(Codes.begin(), Codes.end());
+
+		for (size_t i = 0; i < Codes.size(); ++i)
+		{
+			Primitive.Code = Codes[i];
+			Catalog->Append(Codes[i], Census.Add(Primitive));
+		}
+
+		cout << "done.\n\n";
+		return Set.Count();
+	}
+
+	for (int i = 0; i < PolygonHashSet::NumberOfShards; ++i)
+	{
+		PolygonHashSet::Shard &Source = Set.Shards[i];
+
+		for (uint64 j = 0; j < Source.Capacity; ++j)
+		{
+			if (Source.Slots[j] != PolygonHashSet::EmptySlot)
+			{
+				Primitive.Code = Source.Slots[j];
+				Census.Add(Primitive);
+			}
+		}
+	}
+
+	cout << "done.\n\n";
+
+	return Set.Count();
+}
+
+/* *** ANALYSIS OF SELF-AVOIDING POLYGONS *** */
+
+/* The list of primitive codes is sorted by a parallel LSD radix sort:  in every pass, each thread counts the
+   digits of its share of the codes, the counts are turned into private output positions, and each thread
+   scatters its codes into the other one of two "ping-pong" arrays.  Nothing is copied back between passes.
+   In the final pass, duplicates are skipped and the symmetry of each unique polygon is examined right away. */
+
+/* Bits per Digit of Radix Sort */
+const int RadixBits = 11;
+const int RadixBuckets = (1 << RadixBits);
+
+struct AnalysisTimes
+{
+/* Time Spent on Each Phase of the Analysis (in seconds):  Reduction to Primitives, Sort,
+   Elimination of Duplicates Together With the Census of Symmetry Classes (done in one pass) */
+	double Reduce;
+	double Sort;
+	double Census;
+};
+
+void RunInParallel (int NumberOfThreads, const std::function<void (int)> &Task)
+{
+/* Run a Task on Several Threads (thread number is passed to the task), Wait Until All Are Done */
+	if (NumberOfThreads == 1)
+	{
+		Task(0);
+		return;
+	}
+
+	std::vector<std::thread> Workers;
+
+	for (int t = 0; t < NumberOfThreads; ++t)  Workers.push_back(std::thread(Task, t));
+	for (int t = 0; t < NumberOfThreads; ++t)  Workers[t].join();
+}
+
+uint64 SortOutPolygons (CodeArena &Polygon, int Length, int NumberOfThreads, SymmetryCensus &Census, AnalysisTimes &Times,
+						CatalogWriter *Catalog)
+{
+/* Reduce Closed Chains to Primitive Polygons, Sort Them, Eliminate Duplicates, and Examine Their Symmetry
+   Unique Polygons Go to the Catalog, Unless It is NULL
+   Function Value Returned is the Number of Unique Polygons
+   Note: The Pages of the Polygon Storage Are Released on the Way to Save Memory */
+
+	uint64 ClosedChains = Polygon.Count;
+
+/* Share of Codes for Each Thread */
+	std::vector<uint64> Begin(NumberOfThreads + 1);
+	for (int t = 0; t <= NumberOfThreads; ++t)  Begin[t] = (ClosedChains * t) / NumberOfThreads;
+
+/* *** Step #1:  Find Reduced Polygon Codes, Copy Them Into Code Array */
+	cout << "Reduce to Primitives ... ";
+	TimePoint PhaseStart = Now();
+
+/* Create Arrays for Polygon Codes (sort runs back and forth between them) */
+	uint64 *CodeArray = new uint64[ClosedChains];
+	uint64 *WorkArray = new uint64[ClosedChains];
+
+	size_t NumberOfPages = (size_t)((ClosedChains + CodeArena::PageSize - 1) >> CodeArena::PageBits);
+
+/* Threads Take Turns on Storage Pages, Get Rid of Each Page Once Copied */
+	RunInParallel(NumberOfThreads, [&] (int ThreadID)
+	{
+		PolyMath WorkPolygon;
+		WorkPolygon.Length = Length;
+
+		for (size_t Page = ThreadID; Page < NumberOfPages; Page += NumberOfThreads)
+		{
+			uint64 First = (uint64)Page << CodeArena::PageBits;
+			uint64 Last = First + CodeArena::PageSize;
+			if (Last > ClosedChains)  Last = ClosedChains;
+
+			for (uint64 i = First; i < Last; ++i)
+			{
+				WorkPolygon.Code = Polygon[i];
+				WorkPolygon.Reduce();
+				CodeArray[i] = WorkPolygon.Code;
+			}
+
+			Polygon.ReleasePage(Page);
+		}
+	});
+
+/* Get Rid of the Original Polygon Storage */
+	Polygon.Release();
+
+	TimePoint PhaseEnd = Now();
+	Times.Reduce = Duration(PhaseStart, PhaseEnd);
+	PhaseStart = PhaseEnd;
+
+	cout << "done.\n";
+
+/* *** Step #2:  Sort List of Primitives (using a parallel radix sort, lowest digit first) */
+	cout << "Sort List of Primitives ... ";
+
+/* Digit Counts and Output Positions for Each Thread */
+	std::vector<uint64> Histogram((size_t)NumberOfThreads * RadixBuckets);
+
+	for (int Shift = 0; Shift < Length; Shift += RadixBits)
+	{
+	/* Count Digits */
+		RunInParallel(NumberOfThreads, [&] (int ThreadID)
+		{
+			uint64 *Counts = &Histogram[(size_t)ThreadID * RadixBuckets];
+			std::fill(Counts, Counts + RadixBuckets, (uint64)0);
+
+			for (uint64 i = Begin[ThreadID]; i < Begin[ThreadID + 1]; ++i)  ++Counts[(CodeArray[i] >> Shift) & (RadixBuckets - 1)];
+		});
+
+	/* Turn Digit Counts Into Output Positions (bucket by bucket, thread by thread) */
+		uint64 Position = 0;
+		bool IsSingleBucket = false;
+
+		for (int b = 0; b < RadixBuckets; ++b)
+		{
+			uint64 BucketStart = Position;
+
+			for (int t = 0; t < NumberOfThreads; ++t)
+			{
+				uint64 Counted = Histogram[(size_t)t * RadixBuckets + b];
+				Histogram[(size_t)t * RadixBuckets + b] = Position;
+				Position += Counted;
+			}
+
+			if ((Position - BucketStart) == ClosedChains)  IsSingleBucket = true;
+		}
+
+	/* All Codes Share This Digit:  Nothing to Do in This Pass */
+		if (IsSingleBucket)  continue;
+
+	/* Scatter Codes Into Work Array */
+		RunInParallel(NumberOfThreads, [&] (int ThreadID)
+		{
+			uint64 *Positions = &Histogram[(size_t)ThreadID * RadixBuckets];
+
+			for (uint64 i = Begin[ThreadID]; i < Begin[ThreadID + 1]; ++i)
+			{
+				uint64 Code = CodeArray[i];
+				WorkArray[Positions[(Code >> Shift) & (RadixBuckets - 1)]++] = Code;
+			}
+		});
+
+	/* Swap Roles of Arrays */
+		std::swap(CodeArray, WorkArray);
+	}
+
+/* Sort Done, Work Array No Longer Needed */
+	delete[] WorkArray;
+
+	PhaseEnd = Now();
+	Times.Sort = Duration(PhaseStart, PhaseEnd);
+	PhaseStart = PhaseEnd;
+
+	cout << "done.\n";
+
+/* *** Step #3:  Eliminate Duplicates From List, Examine Symmetry Properties of Unique Polygons */
+/* (Note:  Possibilities are 1, 2, 3, 6-fold rotational symmetry, perhaps with additional mirror symmetry.) */
+	cout << "Eliminate Duplicates, Examine Symmetry Properties ... ";
+
+	std::vector<SymmetryCensus> PartialCensus(NumberOfThreads);
+	std::vector<uint64> PartialCount(NumberOfThreads, 0);
+
+/* Symmetry Classes of the Unique Polygons in Each Thread's Share, in Order, Kept for the Catalog */
+	std::vector<std::vector<unsigned char> > PartialClasses((Catalog != NULL) ? NumberOfThreads : 0);
+
+	RunInParallel(NumberOfThreads, [&] (int ThreadID)
+	{
+		PolyMath Primitive;
+		Primitive.Length = Length;
+
+		for (uint64 i = Begin[ThreadID]; i < Begin[ThreadID + 1]; ++i)
+		{
+		/* Found a New Type of Polygon? */
+			if ((i == 0) || (CodeArray[i] != CodeArray[i - 1]))
+			{
+				Primitive.Code = CodeArray[i];
+				int Class = PartialCensus[ThreadID].Add(Primitive);
+				if (Catalog != NULL)  PartialClasses[ThreadID].push_back((unsigned char)Class);
+
+				++PartialCount[ThreadID];
+			}
+		}
+	});
+
+/* Collect Results of All Threads */
+	uint64 UniquePolygons = 0;
+
+	for (int t = 0; t < NumberOfThreads; ++t)
+	{
+		Census += PartialCensus[t];
+		UniquePolygons += PartialCount[t];
+	}
+
+/* Write Catalog in Order (thread by thread:  class n of a share belongs to its n-th unique polygon) */
+	if (Catalog != NULL)
+	{
+		for (int t = 0; t < NumberOfThreads; ++t)
+		{
+			size_t Unique = 0;
+
+			for (uint64 i = Begin[t]; i < Begin[t + 1]; ++i)
+			{
+				if ((i == 0) || (CodeArray[i] != CodeArray[i - 1]))  Catalog->Append(CodeArray[i], PartialClasses[t][Unique++]);
+			}
+
+			std::vector<unsigned char>().swap(PartialClasses[t]);
+		}
+	}
+
+/* Memory Clean-Up */
+	delete[] CodeArray;
+
+	Times.Census = Duration(PhaseStart, Now());
+
+	cout << "done.\n\n";
+
+	return UniquePolygons;
+}
+
+/* *** IN-PLACE ANALYSIS OF POLYGONS *** */
+
+/* For the largest runs, the analysis may work in the polygon storage itself, without any second array:  the
+   closed chains are reduced to primitive codes page by page, in place, and then sorted by an American flag sort
+   (an in-place MSD radix sort with 8-bit digits):  the codes of a section are counted by their digit, then moved
+   into their buckets along cycles of exchanges, and each bucket is sorted on the next digit.  Large sections are
+   split by the first thread, and the rest are shared by all threads, largest first.  Finally, duplicates are
+   squeezed out toward the front of the storage, pages past the unique codes are released, and the symmetry of
+   the unique polygons is examined.  Extra memory is limited to the page directory and a few counters per digit,
+   so that peak memory stays at the size of the stored codes, instead of up to three times that size. */
+
+/* Digits of the Flag Sort, Smallest Section Split by Digits (smaller ones:  insertion sort) */
+const int FlagBits = 8;
+const int FlagBuckets = (1 << FlagBits);
+const uint64 FlagMinSection = 64;
+
+class PagedCodes
+{
+/* Plain View of the Codes in Polygon Storage (pages are not allocated or released meanwhile) */
+public:
+	PagedCodes (CodeArena &Polygon)
+	{
+		size_t NumberOfPages = (size_t)((Polygon.Count + CodeArena::PageSize - 1) >> CodeArena::PageBits);
+
+		Pages.resize(NumberOfPages);
+		for (size_t Page = 0; Page < NumberOfPages; ++Page)  Pages[Page] = Polygon.Pages[Page].load();
+	}
+
+	inline uint64 &operator [] (uint64 i)
+	{
+		return Pages[(size_t)(i >> CodeArena::PageBits)][i & (CodeArena::PageSize - 1)];
+	}
+
+private:
+	std::vector<uint64 *> Pages;
+};
+
+struct FlagSection
+{
+/* Codes Begin ... End - 1, Sorted Down to Bit Shift + FlagBits (all codes share the higher bits) */
+	uint64 Begin;
+	uint64 End;
+	int Shift;
+};
+
+inline void InsertionSort (PagedCodes &Codes, uint64 Begin, uint64 End)
+{
+/* Sort a Short Section of Codes */
+	for (uint64 i = Begin + 1; i < End; ++i)
+	{
+		uint64 Code = Codes[i];
+		uint64 j = i;
+
+		while ((j > Begin) && (Codes[j - 1] > Code))
+		{
+			Codes[j] = Codes[j - 1];
+			--j;
+		}
+
+		Codes[j] = Code;
+	}
+}
+
+void FlagPartition (PagedCodes &Codes, const FlagSection &Section, std::vector<FlagSection> *Buckets)
+{
+/* Move the Codes of a Section Into Buckets by Their Digit at Bit Shift, in Place
+   The Buckets Are Sorted Right Away (Buckets == NULL), or Handed Back for Later */
+	uint64 Count[FlagBuckets] = {0};
+	uint64 Next[FlagBuckets], Last[FlagBuckets];
+	const int Shift = Section.Shift;
+
+	for (uint64 i = Section.Begin; i < Section.End; ++i)  ++Count[(Codes[i] >> Shift) & (FlagBuckets - 1)];
+
+	uint64 Position = Section.Begin;
+	for (int b = 0; b < FlagBuckets; ++b)
+	{
+		Next[b] = Position;
+		Position += Count[b];
+		Last[b] = Position;
+	}
+
+/* Cycles of Exchanges:  Each Code Taken Out Is Put Into Place, Evicting the Next One */
+	for (int b = 0; b < FlagBuckets; ++b)
+	{
+		while (Next[b] < Last[b])
+		{
+			uint64 Code = Codes[Next[b]];
+			int Digit = (int)((Code >> Shift) & (FlagBuckets - 1));
+
+			while (Digit != b)
+			{
+				std::swap(Code, Codes[Next[Digit]++]);
+				Digit = (int)((Code >> Shift) & (FlagBuckets - 1));
+			}
+
+			Codes[Next[b]++] = Code;
+		}
+	}
+
+/* Sort Each Bucket on the Next Digit (the last digit may overlap lower bits already sorted) */
+	if (Shift == 0)  return;
+
+	uint64 Begin = Section.Begin;
+
+	for (int b = 0; b < FlagBuckets; ++b)
+	{
+		FlagSection Bucket = {Begin, Begin + Count[b], (Shift > FlagBits) ? Shift - FlagBits : 0};
+		Begin += Count[b];
+
+		if (Count[b] < 2)  continue;
+
+		if (Buckets != NULL)
+			Buckets->push_back(Bucket);
+		else if (Count[b] < FlagMinSection)
+			InsertionSort(Codes, Bucket.Begin, Bucket.End);
+		else
+			FlagPartition(Codes, Bucket, NULL);
+	}
+}
+
+uint64 SortOutPolygonsInPlace (CodeArena &Polygon, int Length, int NumberOfThreads, SymmetryCensus &Census,
+							   AnalysisTimes &Times, CatalogWriter *Catalog)
+{
+/* Reduce Closed Chains to Primitive Polygons, Sort Them, Eliminate Duplicates, and Examine Their Symmetry,
+   All Within Polygon Storage (unique polygons go to the catalog, unless it is NULL)
+   Function Value Returned is the Number of Unique Polygons; Storage Is Released on the Way */
+
+	uint64 ClosedChains = Polygon.Count;
+	size_t NumberOfPages = (size_t)((ClosedChains + CodeArena::PageSize - 1) >> CodeArena::PageBits);
+	PagedCodes Codes(Polygon);
+
+/* *** Step #1:  Reduce Codes in Place, Threads Take Pages in Turn */
+	cout << "Reduce to Primitives (in place) ... ";
+	TimePoint PhaseStart = Now();
+
+	std::vector<uint64> HighBits(NumberOfThreads, 0);
+
+	RunInParallel(NumberOfThreads, [&] (int ThreadID)
+	{
+		PolyMath WorkPolygon;
+		WorkPolygon.Length = Length;
+
+		for (size_t Page = ThreadID; Page < NumberOfPages; Page += NumberOfThreads)
+		{
+			uint64 First = (uint64)Page << CodeArena::PageBits;
+			uint64 Last = First + CodeArena::PageSize;
+			if (Last > ClosedChains)  Last = ClosedChains;
+
+			for (uint64 i = First; i < Last; ++i)
+			{
+				WorkPolygon.Code = Codes[i];
+				WorkPolygon.Reduce();
+				Codes[i] = WorkPolygon.Code;
+
+				HighBits[ThreadID] |= WorkPolygon.Code;
+			}
+		}
+	});
+
+	TimePoint PhaseEnd = Now();
+	Times.Reduce = Duration(PhaseStart, PhaseEnd);
+	PhaseStart = PhaseEnd;
+
+	cout << "done.\n";
+
+/* *** Step #2:  Sort by American Flag Sort, Starting With the Highest Digit in Use */
+	cout << "Sort List of Primitives (in place) ... ";
+
+	uint64 AllBits = 0;
+	for (int t = 0; t < NumberOfThreads; ++t)  AllBits |= HighBits[t];
+
+	int TopShift = (AllBits == 0) ? 0 : std::max(HighestBit(AllBits) + 1 - FlagBits, 0);
+
+/* Split Large Sections (first thread), Then Share the Rest Among All Threads, Largest First */
+	std::vector<FlagSection> Sections;
+	FlagSection All = {0, ClosedChains, TopShift};
+
+	if (ClosedChains >= FlagMinSection)  Sections.push_back(All);
+	else  InsertionSort(Codes, 0, ClosedChains);
+
+	uint64 LargeSection = std::max(ClosedChains / (8 * (uint64)NumberOfThreads), FlagMinSection);
+	std::vector<FlagSection> Pending;
+
+	while (!Sections.empty())
+	{
+		FlagSection Section = Sections.back();
+		Sections.pop_back();
+
+		if (((Section.End - Section.Begin) > LargeSection) && (NumberOfThreads > 1))
+			FlagPartition(Codes, Section, &Sections);
+		else
+			Pending.push_back(Section);
+	}
+
+	std::sort(Pending.begin(), Pending.end(), [] (const FlagSection &a, const FlagSection &b)
+		{ return (a.End - a.Begin) > (b.End - b.Begin); });
+
+	std::atomic<size_t> NextSection(0);
+
+	RunInParallel(NumberOfThreads, [&] (int)
+	{
+		size_t i;
+
+		while ((i = NextSection++) < Pending.size())
+		{
+			if ((Pending[i].End - Pending[i].Begin) < FlagMinSection)
+				InsertionSort(Codes, Pending[i].Begin, Pending[i].End);
+			else
+				FlagPartition(Codes, Pending[i], NULL);
+		}
+	});
+
+	PhaseEnd = Now();
+	Times.Sort = Duration(PhaseStart, PhaseEnd);
+	PhaseStart = PhaseEnd;
+
+	cout << "done.\n";
+
+/* *** Step #3:  Squeeze Out Duplicates, Release Pages Beyond the Unique Codes, Examine Symmetry Properties */
+	cout << "Eliminate Duplicates, Examine Symmetry Properties ... ";
+
+	uint64 UniquePolygons = 0;
+
+	for (uint64 i = 0; i < ClosedChains; ++i)
+	{
+		if ((UniquePolygons == 0) || (Codes[i] != Codes[UniquePolygons - 1]))  Codes[UniquePolygons++] = Codes[i];
+	}
+
+	size_t UsedPages = (size_t)((UniquePolygons + CodeArena::PageSize - 1) >> CodeArena::PageBits);
+	for (size_t Page = UsedPages; Page < NumberOfPages; ++Page)  Polygon.ReleasePage(Page);
+
+	if (Catalog != NULL)
+	{
+	/* Catalog Takes the Codes in Order (no room kept for symmetry classes:  one thread examines all) */
+		PolyMath Primitive;
+		Primitive.Length = Length;
+
+		for (uint64 i = 0; i < UniquePolygons; ++i)
+		{
+			Primitive.Code = Codes[i];
+			Catalog->Append(Codes[i], Census.Add(Primitive));
+		}
+	}
+	else
+	{
+		std::vector<SymmetryCensus> PartialCensus(NumberOfThreads);
+
+		RunInParallel(NumberOfThreads, [&] (int ThreadID)
+		{
+			PolyMath Primitive;
+			Primitive.Length = Length;
+
+			uint64 First = (UniquePolygons * ThreadID) / NumberOfThreads;
+			uint64 Last = (UniquePolygons * (ThreadID + 1)) / NumberOfThreads;
+
+			for (uint64 i = First; i < Last; ++i)
+			{
+				Primitive.Code = Codes[i];
+				PartialCensus[ThreadID].Add(Primitive);
+			}
+		});
+
+		for (int t = 0; t < NumberOfThreads; ++t)  Census += PartialCensus[t];
+	}
+
+/* Get Rid of the Polygon Storage */
+	Polygon.Release();
+
+	Times.Census = Duration(PhaseStart, Now());
+
+	cout << "done.\n\n";
+
+	return UniquePolygons;
+}
+
+/* *** STREAMING ANALYSIS OF POLYGONS (EXTERNAL MEMORY) *** */
+
+/* In streaming mode, closed chains are reduced to primitive polygon codes as soon as they are found.
+   Every thread collects them in a run buffer of fixed size; a full buffer is sorted, freed of duplicates,
+   and written to disk as a "run".  In the end, a k-way merge of all runs eliminates the remaining duplicates
+   and examines the symmetry of each unique polygon on the fly.  Memory use is bounded by the run buffers,
+   rather than by the total number of polygons. */
+
+/* Maximum Number of Runs Merged at a Time */
+const int MaxMergeWays = 128;
+
+/* Read Buffer for Each Run File (number of codes) */
+const size_t RunReadBuffer = 8192;
+
+class PolygonRuns
+{
+/* Bookkeeping for the Sorted Run Files on Disk */
+public:
+	std::basic_string<_TCHAR> Prefix;
+	std::atomic<int> Count;
+
+	PolygonRuns (const _TCHAR *prefix)
+	{
+		Prefix = prefix;
+		Count = 0;
+	}
+
+	std::basic_string<_TCHAR> Name (int Run)
+	{
+	/* File Name of a Run:  Prefix.runNNNNNN */
+		std::basic_ostringstream<_TCHAR> FileName;
+		FileName << Prefix << _T(".run") << std::setw(6) << std::setfill(_T('0')) << Run;
+		return FileName.str();
+	}
+};
+
+struct RunBuffer
+{
+/* Primitive Polygon Codes Collected by a Single Thread */
+	uint64 *Codes;
+	size_t Count;
+	size_t Capacity;
+};
+
+void FlushRunBuffer (RunBuffer &Buffer, PolygonRuns &Runs)
+{
+/* Sort Contents of Run Buffer, Eliminate Duplicates, Write Them to Disk as a New Run */
+
+	if (Buffer.Count == 0)  return;
+
+	std::sort(Buffer.Codes, Buffer.Codes + Buffer.Count);
+	size_t UniqueCodes = std::unique(Buffer.Codes, Buffer.Codes + Buffer.Count) - Buffer.Codes;
+
+	std::basic_string<_TCHAR> FileName = Runs.Name(Runs.Count++);
+	FILE *File = _tfopen(FileName.c_str(), _T("wb"));
+
+	bool Success = (File != NULL) && (fwrite(Buffer.Codes, sizeof(uint64), UniqueCodes, File) == UniqueCodes);
+	if ((File != NULL) && (fclose(File) != 0))  Success = false;
+
+	if (!Success)
+	{
+		cerr << "ERROR:  Could not write run file\n";
+		exit(1);
+	}
+
+	Buffer.Count = 0;
+}
+
+class RunReader
+{
+/* Sequential Access to the Codes in a Run File */
+public:
+	FILE *File;
+	uint64 *Buffer;
+	size_t Count;
+	size_t Position;
+
+	RunReader ()
+	{
+	/* Default Constructor */
+		File = NULL;
+		Buffer = new uint64 [RunReadBuffer];
+		Count = 0;
+		Position = 0;
+	}
+
+	~RunReader ()
+	{
+		if (File != NULL)  fclose(File);
+		delete[] Buffer;
+	}
+
+	bool Open (const std::basic_string<_TCHAR> &FileName)
+	{
+		File = _tfopen(FileName.c_str(), _T("rb"));
+		return (File != NULL);
+	}
+
+	bool Next (uint64 &Code)
+	{
+	/* Fetch Next Code, Refill Buffer As Necessary (returns false at end of run) */
+		if (Position == Count)
+		{
+			Count = fread(Buffer, sizeof(uint64), RunReadBuffer, File);
+			Position = 0;
+
+			if (Count == 0)  return false;
+		}
+
+		Code = Buffer[Position++];
+		return true;
+	}
+};
+
+uint64 MergeRuns (PolygonRuns &Runs, int FirstRun, int EndRun, FILE *Output, int Length, SymmetryCensus *Census,
+				  CatalogWriter *Catalog)
+{
+/* k-Way Merge of Runs FirstRun ... EndRun - 1, With Elimination of Duplicates
+   Unique Codes Are Written to Output (intermediate pass) or Examined for Symmetry (final pass, added to catalog if any)
+   Function Value Returned is the Number of Unique Codes */
+
+	int Ways = EndRun - FirstRun;
+	RunReader *Readers = new RunReader [Ways];
+
+/* Smallest Pending Code of Every Run, Together With Run Number */
+	typedef std::pair<uint64, int> RunHead;
+	std::priority_queue<RunHead, std::vector<RunHead>, std::greater<RunHead> > Heads;
+
+	for (int w = 0; w < Ways; ++w)
+	{
+		if (!Readers[w].Open(Runs.Name(FirstRun + w)))
+		{
+			cerr << "ERROR:  Could not read run file\n";
+			exit(1);
+		}
+
+		uint64 Code;
+		if (Readers[w].Next(Code))  Heads.push(RunHead(Code, w));
+	}
+
+	uint64 UniqueCodes = 0;
+	uint64 PreviousCode = 0;
+
+	while (!Heads.empty())
+	{
+		RunHead Head = Heads.top();
+		Heads.pop();
+
+		if ((UniqueCodes == 0) || (Head.first != PreviousCode))
+		{
+		/* Found a New Type of Polygon */
+			PreviousCode = Head.first;
+			++UniqueCodes;
+
+			if (Output != NULL)
+			{
+				fwrite(&PreviousCode, sizeof(uint64), 1, Output);
+			}
+			else
+			{
+				PolyMath Primitive;
+				Primitive.Code = PreviousCode;
+				Primitive.Length = Length;
+
+				int Class = Census->Add(Primitive);
+				if (Catalog != NULL)  Catalog->Append(PreviousCode, Class);
+			}
+		}
+
+	/* Advance in Run */
+		uint64 Code;
+		if (Readers[Head.second].Next(Code))  Heads.push(RunHead(Code, Head.second));
+	}
+
+	delete[] Readers;
+	return UniqueCodes;
+}
+
+uint64 MergePolygonRuns (PolygonRuns &Runs, int Length, SymmetryCensus &Census, CatalogWriter *Catalog)
+{
+/* Merge All Runs, Eliminate Duplicates, and Examine the Symmetry of the Unique Polygons (added to catalog, if any)
+   Function Value Returned is the Number of Unique Polygons; Run Files Are Removed */
+
+	cout << "Merge " << Runs.Count << " Sorted Run(s), Eliminate Duplicates, Examine Symmetry Properties ... ";
+
+	int FirstRun = 0;
+
+/* Intermediate Passes:  Combine the Oldest Runs Into a New One, Until Few Enough Are Left */
+	while (Runs.Count - FirstRun > MaxMergeWays)
+	{
+		int EndRun = FirstRun + MaxMergeWays;
+
+		std::basic_string<_TCHAR> FileName = Runs.Name(Runs.Count++);
+		FILE *Output = _tfopen(FileName.c_str(), _T("wb"));
+
+		if (Output == NULL)
+		{
+			cerr << "ERROR:  Could not write run file\n";
+			exit(1);
+		}
+
+		MergeRuns(Runs, FirstRun, EndRun, Output, Length, NULL, NULL);
+
+	/* Merged Run Must Be Complete Before Its Inputs Are Removed (disk full:  codes would be lost) */
+		bool Success = (ferror(Output) == 0);
+		if (fclose(Output) != 0)  Success = false;
+
+		if (!Success)
+		{
+			cerr << "ERROR:  Could not write run file\n";
+			exit(1);
+		}
+
+		for (int Run = FirstRun; Run < EndRun; ++Run)  _tremove(Runs.Name(Run).c_str());
+
+		FirstRun = EndRun;
+	}
+
+/* Final Pass */
+	uint64 UniquePolygons = MergeRuns(Runs, FirstRun, Runs.Count, NULL, Length, &Census, Catalog);
+
+	for (int Run = FirstRun; Run < Runs.Count; ++Run)  _tremove(Runs.Name(Run).c_str());
+
+	cout << "done.\n\n";
+
+	return UniquePolygons;
+}
+
+/* *** PARALLEL ENUMERATION *** */
+
+/* The code space is split on the top bits of the chain code into prefix ranges.
+   Chains in different ranges share no segments beyond the prefix, so every thread
+   can run the complete incremental algorithm (rebuild, overlap check, smart jump)
+   on its own chain copy, inside the limits of one range. */
+
+/* Longest Chains With 64-Bit Polygon Codes, Longest Chains Searched at All (counters have 64 bits) */
+const int MaxCodeLength = 63;
+const int MaxChainLength = 72;
+
+inline int CodeBits (int Length)
+{
+/* Number of Turns Represented in the Code Space (all free turns, if they fit) */
+	return ((Length <= MaxCodeLength) ? Length : MaxCodeLength) - 2;
+}
+
+enum EnumerationEngine {EngineByCode = 0, EngineDepthFirst = 1, EngineHalfChainJoin = 2, EngineTransferMatrix = 3};
+
+struct CodeRange
+{
+/* A Contiguous Section of the Code Space:  FirstCode <= Code < EndCode */
+	uint64 FirstCode;
+	uint64 EndCode;
+};
+
+class WorkQueue
+{
+/* Code Ranges Waiting for Evaluation by a Thread
+   (owner takes ranges from the front, idle threads steal from the back) */
+public:
+	std::mutex Lock;
+	std::deque<CodeRange> Ranges;
+
+	bool Pop (CodeRange &Range)
+	{
+	/* Take Next Range From the Front of the Queue */
+		std::lock_guard<std::mutex> Guard(Lock);
+
+		if (Ranges.empty())  return false;
+
+		Range = Ranges.front();
+		Ranges.pop_front();
+		return true;
+	}
+
+	bool Steal (CodeRange &Range)
+	{
+	/* Take Last Range From the Back of the Queue */
+		std::lock_guard<std::mutex> Guard(Lock);
+
+		if (Ranges.empty())  return false;
+
+		Range = Ranges.back();
+		Ranges.pop_back();
+		return true;
+	}
+};
+
+struct EnumerationTally
+{
+/* Counters Collected by a Single Thread */
+	uint64 NonOverlaps;
+	uint64 ClosedChains;
+	uint64 ChainChecks;
+};
+
+class CheckpointControl;
+class StatisticsAccumulator;
+
+struct EnumerationJob
+{
+/* Information Shared by All Threads */
+	int Length;
+	uint64 MaxCode;
+	int NumberOfThreads;
+
+/* Method of Enumeration, Method of Overlap Check */
+	EnumerationEngine Engine;
+	OverlapEngine Overlap;
+
+/* One Work Queue per Thread */
+	WorkQueue *Queues;
+
+/* Common Storage for Self-Avoiding Polygon Chains */
+	PolygonStorage Storage;
+	CodeArena *Polygon;
+	PolygonHashSet *UniqueSet;
+
+/* Streaming Mode:  Run Buffer for Each Thread, Run Files (NULL: storage in memory) */
+	RunBuffer *Buffers;
+	PolygonRuns *Runs;
+
+/* Counters of All Threads */
+	EnumerationTally *Tally;
+
+/* Progress Report:  Size of Completed Code Ranges */
+	std::atomic<uint64> CodesDone;
+	std::mutex ReportLock;
+
+/* Control of Periodic Checkpoints (NULL: no checkpoints) */
+	CheckpointControl *Checkpoint;
+
+/* Use Engines Specialized on Chain Length (if available) */
+	bool Specialized;
+
+/* Length of the Tails Screened in Batches (packed sites only, 0: no batches) */
+	int TailBits;
+
+/* Reduced Enumeration by Chain Reversal (one chain of each reverse pair, counted twice) */
+	bool Reversal;
+
+/* Hot-Path Counters of All Finished Threads (built with USE_COUNTERS) */
+	HotPathCounters Counters;
+
+/* Statistics of Open Chains, One Accumulator per Thread (NULL: no statistics) */
+	StatisticsAccumulator *Statistics;
+};
+
+/* *** CHECKPOINT / RESUME *** */
+
+/* A checkpoint file records the complete state of an enumeration run in binary form:
+   the chain length, the way of enumeration (full or reduced by chain reversal),
+   the counters and unfinished code ranges of every thread,
+   and the codes of all closed polygons found so far.  The threads pause together
+   at their regular progress report while the file is written, so that no range
+   is in transit between work queues. */
+
+/* File Identification */
+const char CheckpointMagic[8] = {'2', 'D', 'C', 'H', 'K', 'P', 'T', '4'};
+
+struct CheckpointData
+{
+/* Contents of a Checkpoint File */
+	int Length;
+	int Reversal;
+	EnumerationTally Totals;
+	std::vector<CodeRange> Ranges;
+	std::vector<uint64> PolygonCodes;
+
+/* Way Polygons Are Kept; Streaming Mode:  Number of Runs on Disk */
+	int Storage;
+	int RunCount;
+};
+
+bool WriteCheckpoint (const _TCHAR *FileName, EnumerationJob &Job, std::vector<CodeRange> &Current)
+{
+/* Save State of Enumeration (Current: unfinished part of the range each thread is working on) */
+
+/* Write to Temporary File First, Keep Previous Checkpoint Until Done */
+	std::basic_string<_TCHAR> TempName = FileName;
+	TempName += _T(".tmp");
+
+	FILE *File = _tfopen(TempName.c_str(), _T("wb"));
+	if (File == NULL)  return false;
+
+/* Header:  Identification, Chain Length, Reduced Enumeration, Number of Threads */
+	int Reversal = Job.Reversal ? 1 : 0;
+
+	fwrite(CheckpointMagic, sizeof(CheckpointMagic), 1, File);
+	fwrite(&Job.Length, sizeof(int), 1, File);
+	fwrite(&Reversal, sizeof(int), 1, File);
+	fwrite(&Job.NumberOfThreads, sizeof(int), 1, File);
+
+/* Per-Thread Sections:  Counters, Unfinished Code Ranges */
+	for (int t = 0; t < Job.NumberOfThreads; ++t)
+	{
+		fwrite(&Job.Tally[t], sizeof(EnumerationTally), 1, File);
+
+		std::deque<CodeRange> &Ranges = Job.Queues[t].Ranges;
+
+		uint64 NumberOfRanges = Ranges.size();
+		if (Current[t].FirstCode < Current[t].EndCode)  ++NumberOfRanges;
+
+		fwrite(&NumberOfRanges, sizeof(uint64), 1, File);
+
+		if (Current[t].FirstCode < Current[t].EndCode)  fwrite(&Current[t], sizeof(CodeRange), 1, File);
+
+		for (size_t i = 0; i < Ranges.size(); ++i)
+		{
+			fwrite(&Ranges[i], sizeof(CodeRange), 1, File);
+		}
+	}
+
+/* Closed Polygon Codes:  Way of Storage, Then Number of Runs Written to Disk (streaming mode),
+   or Number of Codes and Codes (all closed chains, or unique primitives in hash set) */
+	int Storage = Job.Storage;
+	fwrite(&Storage, sizeof(int), 1, File);
+
+	if (Job.Storage == StoreInRuns)
+	{
+		int RunCount = Job.Runs->Count;
+		fwrite(&RunCount, sizeof(int), 1, File);
+	}
+	else if (Job.Storage == StoreInHashSet)
+	{
+		uint64 PolygonCount = Job.UniqueSet->Count();
+		fwrite(&PolygonCount, sizeof(uint64), 1, File);
+
+		for (int i = 0; i < PolygonHashSet::NumberOfShards; ++i)
+		{
+			PolygonHashSet::Shard &Source = Job.UniqueSet->Shards[i];
+
+			for (uint64 j = 0; j < Source.Capacity; ++j)
+			{
+				if (Source.Slots[j] != PolygonHashSet::EmptySlot)  fwrite(&Source.Slots[j], sizeof(uint64), 1, File);
+			}
+		}
+	}
+	else
+	{
+		uint64 PolygonCount = Job.Polygon->Count;
+		fwrite(&PolygonCount, sizeof(uint64), 1, File);
+
+	/* Write Complete Pages First, Then Remainder */
+		for (uint64 i = 0; i < PolygonCount; i += CodeArena::PageSize)
+		{
+			uint64 PageCount = PolygonCount - i;
+			if (PageCount > CodeArena::PageSize)  PageCount = CodeArena::PageSize;
+
+			fwrite(&(*Job.Polygon)[i], sizeof(uint64), (size_t)PageCount, File);
+		}
+	}
+
+	bool Success = (ferror(File) == 0);
+	if (fclose(File) != 0)  Success = false;
+
+/* Replace Previous Checkpoint */
+	if (Success)
+	{
+		_tremove(FileName);
+		Success = (_trename(TempName.c_str(), FileName) == 0);
+	}
+
+	return Success;
+}
+
+bool ReadCheckpoint (const _TCHAR *FileName, CheckpointData &Data)
+{
+/* Load State of an Interrupted Enumeration */
+
+	FILE *File = _tfopen(FileName, _T("rb"));
+	if (File == NULL)  return false;
+
+	bool Success = true;
+
+/* Header:  Identification, Chain Length, Reduced Enumeration, Number of Threads */
+	char Magic[sizeof(CheckpointMagic)];
+	int Threads = 0;
+
+	Data.Length = 0;
+	Data.Reversal = 0;
+	Success = (fread(Magic, sizeof(Magic), 1, File) == 1)
+		&& (memcmp(Magic, CheckpointMagic, sizeof(Magic)) == 0)
+		&& (fread(&Data.Length, sizeof(int), 1, File) == 1)
+		&& (fread(&Data.Reversal, sizeof(int), 1, File) == 1)
+		&& (fread(&Threads, sizeof(int), 1, File) == 1)
+		&& (Data.Length >= 2) && (Data.Length <= MaxChainLength) && (Threads > 0);
+
+	uint64 MaxCode = ((uint64)1 << CodeBits(Data.Length));
+
+/* Per-Thread Sections:  Add Up Counters, Collect Ranges */
+	Data.Totals.NonOverlaps = 0;
+	Data.Totals.ClosedChains = 0;
+	Data.Totals.ChainChecks = 0;
+
+	for (int t = 0; (t < Threads) && Success; ++t)
+	{
+		EnumerationTally Tally;
+		uint64 NumberOfRanges = 0;
+
+		Success = (fread(&Tally, sizeof(EnumerationTally), 1, File) == 1)
+			&& (fread(&NumberOfRanges, sizeof(uint64), 1, File) == 1);
+
+		Data.Totals.NonOverlaps += Tally.NonOverlaps;
+		Data.Totals.ClosedChains += Tally.ClosedChains;
+		Data.Totals.ChainChecks += Tally.ChainChecks;
+
+		for (uint64 i = 0; (i < NumberOfRanges) && Success; ++i)
+		{
+			CodeRange Range;
+			Success = (fread(&Range, sizeof(CodeRange), 1, File) == 1)
+				&& (Range.FirstCode < Range.EndCode) && (Range.EndCode <= MaxCode);
+
+			if (Success)  Data.Ranges.push_back(Range);
+		}
+	}
+
+/* Closed Polygon Codes:  Way of Storage, Then Number of Runs or Codes */
+	uint64 PolygonCount = 0;
+	Data.Storage = StoreInMemory;
+	Data.RunCount = 0;
+
+	if (Success)
+	{
+		Success = (fread(&Data.Storage, sizeof(int), 1, File) == 1);
+	}
+
+	if (Success && (Data.Storage == StoreInRuns))
+	{
+		Success = (fread(&Data.RunCount, sizeof(int), 1, File) == 1) && (Data.RunCount >= 0);
+	}
+	else if (Success)
+	{
+	/* All Closed Chains, or Fewer Unique Primitives (or chains counted twice in reduced enumeration) */
+		Success = (fread(&PolygonCount, sizeof(uint64), 1, File) == 1)
+			&& ((PolygonCount == Data.Totals.ClosedChains)
+				|| ((Data.Reversal != 0) && (PolygonCount <= Data.Totals.ClosedChains))
+				|| ((Data.Length > MaxCodeLength) && (PolygonCount == 0))
+				|| ((Data.Storage == StoreInHashSet) && (PolygonCount <= Data.Totals.ClosedChains)));
+	}
+
+	if (Success)
+	{
+		Data.PolygonCodes.resize((size_t)PolygonCount);
+
+		if (PolygonCount > 0)
+			Success = (fread(&Data.PolygonCodes[0], sizeof(uint64), (size_t)PolygonCount, File) == PolygonCount);
+	}
+
+	fclose(File);
+	return Success;
+}
+
+class CheckpointControl
+{
+/* Synchronizes the Threads for Writing Periodic Checkpoints */
+public:
+	const _TCHAR *FileName;
+	time_t Interval;
+	time_t LastWrite;
+
+	std::mutex Lock;
+	std::condition_variable Resume;
+	bool Requested;
+	int Arrived;
+	int ActiveThreads;
+	uint64 Generation;
+
+/* Unfinished Part of the Current Range of Each Paused Thread */
+	std::vector<CodeRange> Current;
+
+	CheckpointControl (const _TCHAR *name, time_t interval, int threads)
+	{
+		FileName = name;
+		Interval = interval;
+		LastWrite = time(NULL);
+
+		Requested = false;
+		Arrived = 0;
+		ActiveThreads = threads;
+		Generation = 0;
+
+		CodeRange Empty = {0, 0};
+		Current.assign(threads, Empty);
+	}
+
+	void Pause (int ThreadID, CodeRange Rest, EnumerationJob &Job)
+	{
+	/* Called at Progress Report:  Wait for Other Threads If Checkpoint Is Due */
+		std::unique_lock<std::mutex> Guard(Lock);
+
+		if (!Requested)
+		{
+			if (time(NULL) - LastWrite < Interval)  return;
+			Requested = true;
+		}
+
+		Current[ThreadID] = Rest;
+		++Arrived;
+
+		if (Arrived == ActiveThreads)
+		{
+		/* Last Thread to Arrive Writes the File */
+			Write(Job);
+		}
+		else
+		{
+			uint64 MyGeneration = Generation;
+			while (Generation == MyGeneration)  Resume.wait(Guard);
+		}
+	}
+
+	void Retire (int, EnumerationJob &Job)
+	{
+	/* Called When a Thread Runs Out of Work */
+		std::unique_lock<std::mutex> Guard(Lock);
+
+		--ActiveThreads;
+
+		if (Requested && (ActiveThreads > 0) && (Arrived == ActiveThreads))  Write(Job);
+	}
+
+private:
+	void Write (EnumerationJob &Job)
+	{
+	/* Write Checkpoint, Release Paused Threads (lock is held by caller) */
+
+	/* Streaming Mode:  Move Contents of All Run Buffers to Disk First */
+		if (Job.Storage == StoreInRuns)
+		{
+			for (int t = 0; t < Job.NumberOfThreads; ++t)  FlushRunBuffer(Job.Buffers[t], *Job.Runs);
+		}
+
+		if (WriteCheckpoint(FileName, Job, Current))
+		{
+			cerr << "Checkpoint written.\n";
+		}
+		else
+		{
+			cerr << "ERROR:  Could not write checkpoint file\n";
+		}
+
+		CodeRange Empty = {0, 0};
+		Current.assign(Current.size(), Empty);
+
+		Requested = false;
+		Arrived = 0;
+		LastWrite = time(NULL);
+		++Generation;
+		Resume.notify_all();
+	}
+};
+
+void StorePolygon (int ThreadID, uint64 Code, EnumerationJob &Job)
+{
+/* Keep a Closed Self-Avoiding Chain (given by its open chain code) in the Polygon Storage of the Job */
+
+	if (Job.Storage == StoreInMemory)
+	{
+		Job.Polygon->Append(PolyMath(Code, Job.Length).Code);
+	}
+	else
+	{
+	/* Reduce to Primitive Right Away */
+		PolyMath Primitive(Code, Job.Length);
+		Primitive.Reduce();
+
+		if (Job.Storage == StoreInHashSet)
+		{
+		/* Keep Unique Primitives Only */
+			Job.UniqueSet->Insert(Primitive.Code);
+		}
+		else
+		{
+		/* Streaming Mode:  Collect in Run Buffer */
+			RunBuffer &Buffer = Job.Buffers[ThreadID];
+			Buffer.Codes[Buffer.Count++] = Primitive.Code;
+
+			if (Buffer.Count == Buffer.Capacity)  FlushRunBuffer(Buffer, *Job.Runs);
+		}
+	}
+}
+
+/* *** CHAIN STATISTICS *** */
+
+/* Optional statistics of the non-overlapping chains, gathered while they are counted:  the distribution of the
+   end-to-end distance in the lattice metric, and the mean squares of the end-to-end distance and of the radius
+   of gyration (in units of the bond length).  In the plane of the honeycomb lattice, the squared length of a
+   grid vector (x, y, z) is Q = x^2 + y^2 + z^2 - xy - yz - zx bond lengths squared, an integer.  With the sums
+   S of the positions and T of the squared lengths over all M = n + 1 atoms, M^2 Rg^2 = M T - Q(S) is an integer
+   as well, so that all totals are exact.  Every thread keeps the sums for the leading atoms of its chain and
+   only adds the atoms rebuilt since the chain counted last, at close to no cost per chain; in a batch of tails,
+   the sums are carried along the tree of tails with the atoms.  A chain counted twice in the reduced
+   enumeration stands for its reverse, which has the same distances. */
+
+struct ChainStatistics
+{
+/* Totals Over All Non-Overlapping Chains:  Number, Sums of R^2 and of M^2 Rg^2, Histogram of Lattice Distances */
+	uint64 Chains;
+	uint64 SquaredEndToEnd;
+	uint64 SquaredGyration;
+	uint64 EndToEnd[MaxChainLength + 1];
+
+	void Clear ()
+	{
+		memset(this, 0, sizeof(ChainStatistics));
+	}
+
+	ChainStatistics &operator += (const ChainStatistics &Other)
+	{
+	/* Collect Totals of Another Thread */
+		Chains += Other.Chains;
+		SquaredEndToEnd += Other.SquaredEndToEnd;
+		SquaredGyration += Other.SquaredGyration;
+		for (int k = 0; k <= MaxChainLength; ++k)  EndToEnd[k] += Other.EndToEnd[k];
+
+		return *this;
+	}
+};
+
+inline void SiteCoordinates (const LatticeVector &Site, int64 &x, int64 &y, int64 &z)
+{
+/* Grid Coordinates of an Atom */
+	x = Site.n1;
+	y = Site.n2;
+	z = Site.n3;
+}
+
+inline void SiteCoordinates (uint64 Site, int64 &x, int64 &y, int64 &z)
+{
+/* Grid Coordinates of a Packed Atom (bias removed) */
+	x = (int64)(Site & 0xFFFF) - 0x4000;
+	y = (int64)((Site >> 16) & 0xFFFF) - 0x4000;
+	z = (int64)((Site >> 32) & 0xFFFF) - 0x4000;
+}
+
+inline int64 PlaneSquare (int64 x, int64 y, int64 z)
+{
+/* Squared Length of a Grid Vector in the Lattice Plane (bond lengths squared) */
+	return x * x + y * y + z * z - x * y - y * z - z * x;
+}
+
+struct SiteSums
+{
+/* Sums of Positions and Squared Lengths Over a Number of Atoms */
+	int64 X;
+	int64 Y;
+	int64 Z;
+	int64 Squares;
+
+	inline SiteSums Plus (int64 x, int64 y, int64 z) const
+	{
+	/* Sums With One More Atom */
+		SiteSums Result = {X + x, Y + y, Z + z, Squares + PlaneSquare(x, y, z)};
+		return Result;
+	}
+};
+
+class StatisticsAccumulator
+{
+/* Statistics of One Thread, Sums Over the Leading Atoms of Its Current Chain */
+public:
+	ChainStatistics Totals;
+
+	StatisticsAccumulator ()
+	{
+	/* Default Constructor:  No Chains, No Atoms Summed */
+		Totals.Clear();
+		Summed = 0;
+		Sums[0].X = Sums[0].Y = Sums[0].Z = Sums[0].Squares = 0;
+	}
+
+	inline void Rebuilt (int StartPos)
+	{
+	/* Atoms From StartPos On Have Changed */
+		if (Summed > StartPos)  Summed = StartPos;
+	}
+
+	template <class Site>
+	inline const SiteSums &Sum (const Site *Atoms, int Last)
+	{
+	/* Sums Over Atoms 0 ... Last (sums over atoms 0 ... k are kept at position k + 1) */
+		int64 x, y, z;
+
+		for (int k = Summed; k <= Last; ++k)
+		{
+			SiteCoordinates(Atoms[k], x, y, z);
+			Sums[k + 1] = Sums[k].Plus(x, y, z);
+		}
+		if (Summed < Last + 1)  Summed = Last + 1;
+
+		return Sums[Last + 1];
+	}
+
+	inline void Count (int64 x, int64 y, int64 z, const SiteSums &Chain, int Length, uint64 Weight)
+	{
+	/* Count a Chain From the Origin to (x, y, z), With Sums Chain Over All Its Atoms
+	   Weight:  Number of Chains It Stands For */
+		int64 Atoms = Length + 1;
+		int64 Gyration = Atoms * Chain.Squares - PlaneSquare(Chain.X, Chain.Y, Chain.Z);
+
+		Totals.Chains += Weight;
+		Totals.SquaredEndToEnd += Weight * (uint64)PlaneSquare(x, y, z);
+		Totals.SquaredGyration += Weight * (uint64)Gyration;
+		Totals.EndToEnd[llabs(x) + llabs(y) + llabs(z)] += Weight;
+	}
+
+	template <class Site>
+	inline void Add (const Site *Atoms, int Length, uint64 Weight)
+	{
+	/* Count a Non-Overlapping Chain (atoms 0 ... Length, first atom at the origin) */
+		int64 x, y, z;
+
+		const SiteSums &Chain = Sum(Atoms, Length);
+		SiteCoordinates(Atoms[Length], x, y, z);
+
+		Count(x, y, z, Chain, Length, Weight);
+	}
+
+private:
+	int Summed;
+	SiteSums Sums[MaxChainLength + 2];
+};
+
+/* *** BATCHES OF TAILS *** */
+
+/* Sibling chains that share a head of Length - m segments differ only in their last m turns, and the main loop
+   would rebuild and check them one by one.  Once the head is known to be free of overlaps, a batch instead places
+   all 2^(m+1) - 2 atoms of the 2^m tails at once (by levels of the binary tree of turns), and compares them in
+   one pass against the few atoms of the head within reach, i.e. within L1 distance m of the last atom of the
+   head.  A single distance walk finds these atoms; the comparisons use SSE2 where available. */
+
+/* Longest Tail of a Batch (no overlaps inside a tail of 5 segments or less) */
+const int MaxTailBits = 5;
+
+inline void MarkNearSites (const uint64 *Nodes, int Count, const uint64 *Near, int NearCount, bool *Hit)
+{
+/* Mark All Nodes Occupying a Site of the List (Count even) */
+#if defined (HAS_SSE2)
+	for (int i = 0; i < Count; i += 2)
+	{
+		__m128i Pair = _mm_loadu_si128((const __m128i *)&Nodes[i]);
+		__m128i Matches = _mm_setzero_si128();
+
+		for (int k = 0; k < NearCount; ++k)
+		{
+		/* 64-Bit Equality From Both 32-Bit Halves */
+			__m128i Equal = _mm_cmpeq_epi32(Pair, _mm_set1_epi64x((long long)Near[k]));
+			Matches = _mm_or_si128(Matches, _mm_and_si128(Equal, _mm_shuffle_epi32(Equal, _MM_SHUFFLE(2, 3, 0, 1))));
+		}
+
+		int Mask = _mm_movemask_pd(_mm_castsi128_pd(Matches));
+		Hit[i] = ((Mask & 1) != 0);
+		Hit[i + 1] = ((Mask & 2) != 0);
+	}
+#else
+	for (int i = 0; i < Count; ++i)
+	{
+		Hit[i] = false;
+		for (int k = 0; k < NearCount; ++k)
+		{
+			if (Nodes[i] == Near[k])  Hit[i] = true;
+		}
+	}
+#endif
+}
+
+void ScreenTailBatch (int ThreadID, uint64 Code, int HeadLength, int Length, int Weight, const uint64 *Sites, EnumerationTally &Tally, EnumerationJob &Job)
+{
+/* Examine All Completions of a Head Without Overlaps (atoms 0 ... HeadLength, free end zero in Code)
+   Count Non-Overlapping and Closed Chains (Weight: see reduced enumeration), Store Closed Polygons */
+
+	const int TailBits = Length - HeadLength;
+	uint64 Root = Sites[HeadLength];
+
+/* *** Task #1:  Atoms of the Head Within Reach of the Tails (atom 0 is kept apart, closes the loop) */
+	uint64 Near[MaxChainLength + 1];
+	int NearCount = 0;
+
+	for (int k2 = 1; k2 < HeadLength; )
+	{
+		int separation = PackedDistance(Root, Sites[k2]);
+		COUNT(++ThreadCounters.Distances);
+
+		if (separation <= TailBits)  Near[NearCount++] = Sites[k2];
+
+	/* Atoms Closer to Atom k2 Than (separation - TailBits) Are Out of Reach As Well */
+		k2 += (separation > TailBits) ? separation - TailBits : 1;
+	}
+
+	uint64 Start = Sites[0];
+
+/* Statistics:  Sums Over the Head, Carried Along the Tails Level by Level */
+	StatisticsAccumulator *Statistics = (Job.Statistics != NULL) ? &Job.Statistics[ThreadID] : NULL;
+	SiteSums Sums[2][1 << MaxTailBits];
+
+	if (Statistics != NULL)  Sums[0][0] = Statistics->Sum(Sites, HeadLength);
+
+/* *** Task #2:  Place the Tails Level by Level, Keep Track of Nodes Without Overlaps */
+	uint64 Nodes[2][1 << MaxTailBits];
+	int Orientation[2][1 << MaxTailBits];
+	bool Valid[2][1 << MaxTailBits];
+	bool Hit[1 << MaxTailBits];
+
+	Nodes[0][0] = Root;
+	Orientation[0][0] = PackedOrientation(Code, HeadLength + 1, Length);
+	Valid[0][0] = true;
+
+	for (int Level = 1; Level <= TailBits; ++Level)
+	{
+		const int Parent = (Level - 1) & 1, Child = Level & 1;
+		const int Count = 1 << Level;
+
+	/* Node 2i: Left Turn, Node 2i + 1:  Right Turn After Node i */
+		for (int i = 0; i < Count; ++i)
+		{
+			int Turn = i & 1;
+			int d = Orientation[Parent][i >> 1];
+
+			Nodes[Child][i] = Nodes[Parent][i >> 1] + PackedStep[Turn][d];
+			Orientation[Child][i] = NextOrientation[Turn][d];
+		}
+
+		if ((Statistics != NULL) && (Level < TailBits))
+		{
+			int64 x, y, z;
+
+			for (int i = 0; i < Count; ++i)
+			{
+				if (!Valid[Parent][i >> 1])  continue;
+
+				SiteCoordinates(Nodes[Child][i], x, y, z);
+				Sums[Child][i] = Sums[Parent][i >> 1].Plus(x, y, z);
+			}
+		}
+
+		MarkNearSites(Nodes[Child], Count, Near, NearCount, Hit);
+		COUNT(ThreadCounters.Distances += Count * NearCount);
+
+		if (Level < TailBits)
+		{
+			for (int i = 0; i < Count; ++i)
+			{
+				Valid[Child][i] = Valid[Parent][i >> 1] && !Hit[i] && (Nodes[Child][i] != Start);
+			}
+		}
+		else
+		{
+		/* *** Task #3:  Final Atoms - Chains Without Overlaps, Closed Loops (final atom returns to the origin) */
+			for (int i = 0; i < Count; ++i)
+			{
+				if (!Valid[Parent][i >> 1] || Hit[i])  continue;
+
+				if (Nodes[Child][i] == Start)
+				{
+					StorePolygon(ThreadID, Code | (uint64)i, Job);
+					Tally.ClosedChains += Weight;
+					COUNT(++ThreadCounters.LoopsClosed);
+				}
+				else
+				{
+					Tally.NonOverlaps += Weight;
+
+					if (Statistics != NULL)
+					{
+						int64 x, y, z;
+						SiteCoordinates(Nodes[Child][i], x, y, z);
+						Statistics->Count(x, y, z, Sums[Parent][i >> 1].Plus(x, y, z), Length, Weight);
+					}
+				}
+			}
+		}
+	}
+
+/* One Chain Has Been Counted by the Caller */
+	Tally.ChainChecks += ((uint64)1 << TailBits) - 1;
+	COUNT(ThreadCounters.Chains += ((uint64)1 << TailBits) - 1; ++ThreadCounters.Batches);
+}
+
+/* *** CHAIN REVERSAL SYMMETRY *** */
+
+/* The fixed first segment and first (left) turn of every chain take care of the rotations and mirror images
+   of the lattice, but one symmetry remains:  read backwards from its free end, and moved into standard position,
+   a chain is again a chain of the same length, with the same overlaps and the same polygon when closed.  With
+   the bits u_k = t_k XOR t_(k-1) of U = Code XOR (Code >> 1) (a turn opposite to the previous one, or not), the
+   reverse chain has the bits of U in reverse order.  The reduced enumeration compares the pairs of bits i and
+   Length - 3 - i of U, from the middle of the chain outward.  A chain whose first unequal pair has its set bit on
+   the side of the head is skipped (its reverse is counted instead), together with all chains that share its head
+   up to that bit.  A chain with the set bit on the side of the free end is counted twice, a chain with equal
+   pairs once.  Pairs within the last MaxTailBits segments are left out, so that a batch of tails has a single
+   weight, and the scheme is the same for all batch lengths. */
+
+inline uint64 ReversalPairs (int Length)
+{
+/* Bits i of U Compared to Their Partners (MaxTailBits <= i < Length - 3 - i) */
+	int Pairs = (Length - 2) / 2 - MaxTailBits;
+	if (Pairs <= 0)  return 0;
+
+	return (((uint64)1 << Pairs) - 1) << MaxTailBits;
+}
+
+inline int ReversalWeight (uint64 Code, int Length, uint64 Pairs, int &SkipAt)
+{
+/* Weight of a Chain in the Reduced Enumeration (zero: chain counted by its reverse, skip head up to segment SkipAt) */
+	uint64 U = Code ^ (Code >> 1);
+	uint64 Difference = (U ^ (ReverseBits(U) >> (66 - Length))) & Pairs;
+
+	if (Difference == 0)  return 1;
+
+/* First Unequal Pair Decides:  Set Bit Near the Free End, or in the Head */
+	int i = HighestBit(Difference);
+
+	if (((U >> i) & 1) != 0)  return 2;
+
+	SkipAt = Length - i;
+	return 0;
+}
+
+#if defined (USE_COUNTERS)
+
+/* Counters of the Running Thread at Its Last Report */
+static thread_local HotPathCounters ReportedCounters;
+static thread_local TimePoint ReportedAt;
+
+void StartCounters ()
+{
+/* Counting Starts Anew (running thread) */
+	ThreadCounters.Clear();
+	ReportedCounters.Clear();
+	ReportedAt = Now();
+}
+
+void PrintAverages (const HotPathCounters &Counters, double Seconds)
+{
+/* Rates and Averages of a Set of Counters */
+	double Chains = (Counters.Chains > 0) ? (double)Counters.Chains : 1.0;
+	double Checks = (Counters.OverlapChecks > 0) ? (double)Counters.OverlapChecks : 1.0;
+
+	uint64 Jumps = 0, JumpSegments = 0, Branchings = 0, Depth = 0;
+	for (int k = 0; k < HistogramBins; ++k)
+	{
+		Jumps += Counters.Jumps[k];
+		JumpSegments += k * Counters.Jumps[k];
+		Branchings += Counters.Branching[k];
+		Depth += k * Counters.Branching[k];
+	}
+
+	cerr << std::fixed << std::setprecision(2)
+		 << Counters.Chains / Seconds / 1e6 << " M chains/s, branching at segment " << ((Branchings > 0) ? (double)Depth / Branchings : 0.0)
+		 << ", " << Counters.SegmentsRebuilt / Chains << " segments rebuilt per chain, "
+		 << Counters.Distances / Checks << " distances per overlap check\n     "
+		 << Jumps / Seconds / 1e6 << " M smart jumps/s (" << ((Jumps > 0) ? (double)JumpSegments / Jumps : 0.0)
+		 << " segments each), closed loop checks " << Counters.LoopsClosed << " passed / " << Counters.LoopsOpen
+		 << " failed, " << Counters.Batches << " batches of tails, " << Counters.ReversalSkips << " reversal skips\n";
+	cerr.unsetf(std::ios::fixed);
+	cerr << std::setprecision(6);
+}
+
+void ReportCounterRates (int ThreadID)
+{
+/* Rates of the Running Thread Since Its Last Report (caller holds report lock) */
+	TimePoint Time = Now();
+	double Seconds = Duration(ReportedAt, Time);
+	if (Seconds <= 0)  Seconds = 1e-9;
+
+	HotPathCounters Interval = ThreadCounters;
+	uint64 *Target = (uint64 *)&Interval;
+	const uint64 *Last = (const uint64 *)&ReportedCounters;
+	for (size_t i = 0; i < sizeof(HotPathCounters) / sizeof(uint64); ++i)  Target[i] -= Last[i];
+
+	cerr << "  Thread " << ThreadID << ":  ";
+	PrintAverages(Interval, Seconds);
+
+	ReportedCounters = ThreadCounters;
+	ReportedAt = Time;
+}
+
+void PrintCounterTotals (const HotPathCounters &Totals, double Seconds)
+{
+/* Totals of All Threads:  Averages, Histograms of Branching Segments and Jump Sizes (non-empty bins only) */
+	cerr << "\nHot-path counters of all threads:\n  ";
+	PrintAverages(Totals, (Seconds > 0) ? Seconds : 1e-9);
+
+	cerr << "  Branching segment (chains):";
+	for (int k = 0; k < HistogramBins; ++k)
+	{
+		if (Totals.Branching[k] > 0)  cerr << "  " << k << ": " << Totals.Branching[k];
+	}
+
+	cerr << "\n  Smart jump size (jumps):";
+	for (int k = 0; k < HistogramBins; ++k)
+	{
+		if (Totals.Jumps[k] > 0)  cerr << "  " << k << ": " << Totals.Jumps[k];
+	}
+
+	cerr << "\n\n";
+}
+
+#endif
+
+template <int N>
+void EnumerateRange (int ThreadID, CodeRange Range, LatticeVector *ChainArray, OccupancyMap &Map, EnumerationTally &Tally, EnumerationJob &Job)
+{
+/* Examine All Chains in a Code Range, Search for Overlaps and Closed Self-Avoiding Chains
+   (N > 0:  instance for chains of N segments, N = 0:  chains of any length) */
+
+	const int Length = (N > 0) ? N : Job.Length;
+	int OverlapAt, Segment;
+
+/* Auxiliary Variable for Progress Report */
+	uint64 ProgressMark = (uint64)(1 << 24) - 1;
+
+/* Packed Lattice Sites (overlap check by packed sites only) */
+	uint64 Sites[MaxChainLength + 1];
+	bool Packed = (Job.Overlap == OverlapByPackedSites) || (Job.Overlap == OverlapByPackedSimd);
+
+/* Batches of Tails (packed sites only):  Head of Chain (at least the fixed atoms 0, 1, 2), Free End Covered by a Batch */
+	const int TailBits = Packed ? std::min(Job.TailBits, Length - 2) : 0;
+	const int HeadLength = Length - TailBits;
+	const uint64 TailMask = ((uint64)1 << TailBits) - 1;
+	bool Batched;
+
+/* Reduced Enumeration:  Pairs of Bits Compared With Reverse Chain, Weight of Current Chain */
+	const uint64 Pairs = Job.Reversal ? ReversalPairs(Length) : 0;
+	int Weight = 1, SkipAt;
+
+/* Statistics of Open Chains (if any) */
+	StatisticsAccumulator *Statistics = (Job.Statistics != NULL) ? &Job.Statistics[ThreadID] : NULL;
+
+/* Build Initial Chain of Range */
+	uint64 Code = Range.FirstCode;
+	if (Packed)
+	{
+		BuildPackedChain(Code, Length, Sites);
+	}
+	else
+	{
+		BuildChain(Code, Length, ChainArray);
+		if (Job.Overlap == OverlapByBitmap)  Map.Reset(Length, ChainArray);
+	}
+
+/* Use Chain With Opposite First Turn for Initial Comparison
+   (guarantees complete check of initial chain for overlaps) */
+	uint64 LastCode = Code ^ (Job.MaxCode >> 1);
+
+	do
+	{
+	/* *** Task #1:  Skip Chains Counted by Their Reverse, Check Counter */
+
+	/* Jump Over All Chains Sharing the Head (the chain examined last stays in place) */
+		while ((Pairs != 0) && (Code < Range.EndCode) && ((Weight = ReversalWeight(Code, Length, Pairs, SkipAt)) == 0))
+		{
+			COUNT(++ThreadCounters.ReversalSkips);
+
+			Code >>= (Length - SkipAt);
+			++Code;
+			Code <<= (Length - SkipAt);
+		}
+
+		if (Code >= Range.EndCode)  break;
+
+	/* Count Examined Chains: */
+		++Tally.ChainChecks;
+		COUNT(++ThreadCounters.Chains);
+
+	/* *** Task #2:  Find Common Head of Old and New Chains, Rebuild Chain, Check for Overlaps */
+
+	/* Find Branching Segment */
+		Segment = BranchingSegment(Code, LastCode, Length);
+		COUNT(++ThreadCounters.Branching[Segment]);
+		if (Statistics != NULL)  Statistics->Rebuilt(Segment);
+
+	/* First of a Batch of Siblings (all tails of the head, entirely in range)? */
+		Batched = (TailBits > 0) && ((Code & TailMask) == 0) && (Segment <= HeadLength) && (Code + TailMask < Range.EndCode);
+
+	/* Reconstruct Chain As Necessary, Test Chain For Overlaps: */
+		if (Batched)
+		{
+		/* Check Head Only, Then Screen All of Its Tails (the atoms of the tail are not kept) */
+			RebuildPackedChain(Code, Segment, HeadLength, Length, Sites);
+			OverlapAt = PackedChainOverlap(Segment, HeadLength, Sites);
+
+			if (OverlapAt == 0)
+				ScreenTailBatch(ThreadID, Code, HeadLength, Length, Weight, Sites, Tally, Job);
+			else
+				Batched = false;
+		}
+		else if (Job.Overlap == OverlapByBitmap)
+		{
+			OverlapAt = RebuildChainWithMap(Code, Segment, Length, ChainArray, Map);
+		}
+		else if (Job.Overlap == OverlapByPackedSites)
+		{
+			RebuildPackedChain(Code, Segment, Length, Length, Sites);
+			OverlapAt = PackedChainOverlap(Segment, Length, Sites);
+		}
+#if defined (HAS_SSE2)
+		else if (Job.Overlap == OverlapByPackedSimd)
+		{
+			RebuildPackedChain(Code, Segment, Length, Length, Sites);
+			OverlapAt = PackedChainOverlapSimd(Segment, Length, Sites);
+		}
+#endif
+		else
+		{
+			RebuildChain(Code, Segment, Length, ChainArray);
+			OverlapAt = ChainOverlap(Segment, Length, ChainArray);
+		}
+
+	/* *** Task #3:  Intelligent Update of Chain Code, Jump Over Known "Bad" Chains */
+
+	/* Remember Code Used */
+		LastCode = Code;
+
+	/* Analyze Result: Batch of Siblings Done? */
+		if (Batched)
+		{
+			Code += TailMask + 1;
+		}
+	/* Analyze Result: No Overlap? */
+		else if (OverlapAt == 0)
+		{
+			Tally.NonOverlaps += Weight;
+			++Code;
+
+			if (Statistics != NULL)
+			{
+				if (Packed)
+					Statistics->Add(Sites, Length, Weight);
+				else
+					Statistics->Add(ChainArray, Length, Weight);
+			}
+		}
+		else
+		{
+		/* Analyze Result: Closed Non-Overlapping Chain? */
+			if (OverlapAt == Length)
+			{
+				if ((Packed ? PackedClosedLoopCheck(Length, Sites) : ClosedLoopCheck(Length, ChainArray)) == true)
+				{
+					StorePolygon(ThreadID, Code, Job);
+					Tally.ClosedChains += Weight;
+				}
+			}
+
+		/* Perform "Smart Jump" to Next Code Without This Overlap
+		   (a jump past the end of the range skips only overlapping chains) */
+
+			COUNT(++ThreadCounters.Jumps[Length - OverlapAt]);
+
+		/* Remove Trailing End of Code */
+			Code >>= (Length - OverlapAt);
+		/* Step to Next Chain Segment Without This Specific Overlap */
+			++Code;
+		/* Fill Chain with Left Turns:  Lowest Value of Code Without Offending Overlap */
+			Code <<= (Length - OverlapAt);
+		}
+
+	/* *** Task #4:  Progress Indicator, Checkpoint */
+
+	/* Progress Report after 2^24 (about 16 million) Evaluations (a batch may pass the mark) */
+		if ((Tally.ChainChecks & ProgressMark) < (Batched ? TailMask + 1 : 1))
+		{
+			{
+				std::lock_guard<std::mutex> Guard(Job.ReportLock);
+				cerr << 100 * ((float)(Job.CodesDone + (Code - Range.FirstCode)))/Job.MaxCode << "% done.\n";
+				COUNT(ReportCounterRates(ThreadID));
+			}
+
+		/* Save State If Checkpoint Is Due (next chain to be examined is Code) */
+			if (Job.Checkpoint != NULL)
+			{
+				CodeRange Rest;
+				Rest.FirstCode = Code;
+				Rest.EndCode = Range.EndCode;
+
+				Job.Checkpoint->Pause(ThreadID, Rest, Job);
+			}
+		}
+	}
+	while (Code < Range.EndCode);
+
+/* Book Range as Completed */
+	Job.CodesDone += (Range.EndCode - Range.FirstCode);
+}
+
+/* *** DEPTH-FIRST ENUMERATION *** */
+
+/* Alternative engine:  an explicit depth-first search over left and right turns.  The search keeps a stack
+   of turns and orientations, places one atom per step in the occupancy map, and backs up as soon as a site
+   is taken.  Every node where the search stops (overlap, or complete chain) corresponds to one evaluation of
+   the code-based engine, so the counts agree.  The position of the search in the code space is tracked for
+   the first CodeBits turns only; beyond that depth, subtrees are always searched completely.  This lifts the
+   restriction to chains with 64-bit codes (polygons are then counted, but not classified). */
+
+template <int N>
+void EnumerateRangeDepthFirst (int ThreadID, CodeRange Range, LatticeVector *ChainArray, OccupancyMap &Map, EnumerationTally &Tally, EnumerationJob &Job)
+{
+/* Examine All Chains in a Code Range by Depth-First Search, Count Overlaps and Closed Self-Avoiding Chains
+   (N > 0:  instance for chains of N segments, N = 0:  chains of any length) */
+
+	const int Length = (N > 0) ? N : Job.Length;
+
+/* Statistics of Open Chains (if any) */
+	StatisticsAccumulator *Statistics = (Job.Statistics != NULL) ? &Job.Statistics[ThreadID] : NULL;
+
+/* Last Atom Whose Turn Is Part of the Code */
+	int CodeDepth = CodeBits(Length) + 2;
+
+/* Auxiliary Variables for Progress Report */
+	uint64 ProgressMark = (uint64)(1 << 24) - 1;
+	bool IsReportDue = false;
+
+/* Fixed Head of Chain (atoms 0, 1, 2) */
+	BuildChain(0, Length, ChainArray);
+	Map.Reset(Length, ChainArray);
+
+	if (Length < 3)
+	{
+	/* Nothing to Search:  Head Is a Complete Chain */
+		++Tally.ChainChecks;
+		++Tally.NonOverlaps;
+		if (Statistics != NULL)  Statistics->Add(ChainArray, Length, 1);
+		Job.CodesDone += (Range.EndCode - Range.FirstCode);
+		return;
+	}
+
+/* Search Stack:  Turn Leading to Atom k (0: left, 1: right), Orientation of Segment Leaving Atom k,
+   Code Bits of Turns Up to Atom k */
+	std::array<int, MaxChainLength + 1> Turn;
+	std::array<int, MaxChainLength + 1> Orientation;
+	std::array<uint64, MaxChainLength + 1> Prefix;
+
+	Turn.fill(0);
+	Orientation.fill(1);
+	Prefix.fill(0);
+
+/* Smallest Code Not Examined Yet */
+	uint64 Code = Range.FirstCode;
+
+/* Start With Atom #3, Turn Given by Leading Bit of First Code */
+	int k = 3;
+	Turn[k] = (int)((Code >> (CodeDepth - k)) & 1);
+
+	while (k >= 3)
+	{
+	/* *** Task #1:  Place Atom k */
+		ChainArray[k] = ChainArray[k-1];
+		COUNT(++ThreadCounters.SegmentsRebuilt);
+		if (Statistics != NULL)  Statistics->Rebuilt(k);
+
+		if (Turn[k] == 0)
+		{
+			ChainArray[k].LeftTurn(Orientation[k-1]);
+			Orientation[k] = Orientation[k-1] + 1;
+		}
+		else
+		{
+			ChainArray[k].RightTurn(Orientation[k-1]);
+			Orientation[k] = Orientation[k-1] - 1;
+		}
+
+		if (k <= CodeDepth)  Prefix[k] = (Prefix[k-1] << 1) | Turn[k];
+
+	/* *** Task #2:  Check for Overlap, Go Deeper If Possible */
+		bool IsFinished = true;
+
+		if (Map.IsOccupied(ChainArray[k]))
+		{
+			++Tally.ChainChecks;
+			COUNT(++ThreadCounters.Chains);
+
+		/* Closed Non-Overlapping Chain?  (only the first atom can be in the way) */
+			if ((k == Length) && (ChainArray[Length] == ChainArray[0]))
+			{
+				if (Length <= MaxCodeLength)  StorePolygon(ThreadID, Prefix[Length], Job);
+				COUNT(++ThreadCounters.LoopsClosed);
+
+				++Tally.ClosedChains;
+			}
+		}
+		else if (k == Length)
+		{
+		/* Complete Chain Without Overlap */
+			++Tally.ChainChecks;
+			COUNT(++ThreadCounters.Chains);
+			++Tally.NonOverlaps;
+			if (Statistics != NULL)  Statistics->Add(ChainArray, Length, 1);
+		}
+		else
+		{
+		/* Occupy Site, Continue With Next Atom */
+			Map.Set(ChainArray[k]);
+			++k;
+
+			Turn[k] = (k <= CodeDepth) ? (int)((Code >> (CodeDepth - k)) & 1) : 0;
+			IsFinished = false;
+		}
+
+		if ((Tally.ChainChecks & ProgressMark) == 0)  IsReportDue = true;
+
+	/* *** Task #3:  Node Finished - Step to Next Turn, Back Up Past Right Turns */
+		while (IsFinished)
+		{
+		/* Move Past the Codes Below This Node ("smart jump") */
+			if (k <= CodeDepth)
+			{
+				Code = (Prefix[k] + 1) << (CodeDepth - k);
+
+				if (Code >= Range.EndCode)
+				{
+					k = 0;
+					break;
+				}
+
+			/* *** Task #4:  Progress Indicator, Checkpoint (next chain to be examined is Code) */
+				if (IsReportDue)
+				{
+					{
+						std::lock_guard<std::mutex> Guard(Job.ReportLock);
+						cerr << 100 * ((float)(Job.CodesDone + (Code - Range.FirstCode)))/Job.MaxCode << "% done.\n";
+						COUNT(ReportCounterRates(ThreadID));
+					}
+
+					if (Job.Checkpoint != NULL)
+					{
+						CodeRange Rest;
+						Rest.FirstCode = Code;
+						Rest.EndCode = Range.EndCode;
+
+						Job.Checkpoint->Pause(ThreadID, Rest, Job);
+					}
+
+					IsReportDue = false;
+				}
+			}
+
+			if (Turn[k] == 0)
+			{
+			/* Try Right Turn Next */
+				Turn[k] = 1;
+				IsFinished = false;
+			}
+			else
+			{
+			/* Both Turns Done:  Back Up, Free Site of Previous Atom */
+				--k;
+				if (k < 3)  break;
+
+				Map.Clear(ChainArray[k]);
+			}
+		}
+	}
+
+/* Book Range as Completed */
+	Job.CodesDone += (Range.EndCode - Range.FirstCode);
+}
+
+/* *** HALF-CHAIN JOIN FOR POLYGONS *** */
+
+/* Polygons only:  a closed chain of Length segments splits into a head (atoms 0 ... m, a regular chain of
+   m = Length/2 segments) and a tail (atoms Length ... m, read backwards from the origin).  Heads are ordinary
+   self-avoiding chains; tails are self-avoiding chains of Length - m segments that leave the origin in one
+   of the two directions not used by the head - rotated and reflected copies of ordinary chains.  Both are
+   collected once, sorted by the lattice site where they end, and only pairs ending at the same site are
+   joined and checked for overlaps between the two halves.  Open chains of full length are not counted. */
+
+struct HalfChain
+{
+/* A Self-Avoiding Half of a Polygon */
+	size_t EndSite;
+	size_t LastSite;
+	uint64 Code;
+	int Transform;
+
+	bool operator < (const HalfChain &Other) const
+	{
+		return (EndSite < Other.EndSite);
+	}
+};
+
+inline LatticeVector TransformTail (LatticeVector r, int Transform)
+{
+/* Map an Ordinary Chain Onto a Tail:  Rotations by 120/240 Degrees (cyclic permutation of coordinates),
+   Possibly After a Reflection (exchange of n2, n3) */
+	switch (Transform)
+	{
+	case 1:
+		return LatticeVector(r.n3, r.n1, r.n2);
+	case 2:
+		return LatticeVector(r.n2, r.n1, r.n3);
+	case 3:
+		return LatticeVector(r.n2, r.n3, r.n1);
+	case 4:
+		return LatticeVector(r.n3, r.n2, r.n1);
+	default:
+		return r;
+	}
+}
+
+void CollectHalfChains (int length, std::vector<uint64> &Codes)
+{
+/* Find the Codes of All Self-Avoiding Open Chains With (length) Segments (rebuild, overlap check, smart jump) */
+
+	LatticeVector *ChainArray = new LatticeVector [length + 1];
+
+	uint64 MaxCode = ((uint64)1 << (length - 2));
+	uint64 Code = 0;
+
+	BuildChain(Code, length, ChainArray);
+	uint64 LastCode = Code ^ (MaxCode >> 1);
+
+	do
+	{
+		int Segment = BranchingSegment(Code, LastCode, length);
+		RebuildChain(Code, Segment, length, ChainArray);
+		int OverlapAt = ChainOverlap(Segment, length, ChainArray);
+
+		LastCode = Code;
+
+		if (OverlapAt == 0)
+		{
+			Codes.push_back(Code);
+			++Code;
+		}
+		else
+		{
+		/* Smart Jump Past Chains With This Overlap */
+			Code >>= (length - OverlapAt);
+			++Code;
+			Code <<= (length - OverlapAt);
+		}
+	}
+	while (Code < MaxCode);
+
+	delete[] ChainArray;
+}
+
+void JoinHalfChains (EnumerationJob &Job)
+{
+/* Find All Closed Self-Avoiding Chains by Joining Heads and Tails That End at the Same Lattice Site
+   (counters are kept in the tallies of the job, one per thread) */
+
+	int Length = Job.Length;
+	int HeadLength = Length / 2;
+	int TailLength = Length - HeadLength;
+
+/* *** Step #1:  Collect Heads and Tails, Index Them by Final Site */
+	std::vector<uint64> HeadCodes, TailCodes;
+
+	CollectHalfChains(HeadLength, HeadCodes);
+	if (TailLength == HeadLength)
+		TailCodes = HeadCodes;
+	else
+		CollectHalfChains(TailLength, TailCodes);
+
+	OccupancyMap Sites;
+	LatticeVector *ChainArray = new LatticeVector [TailLength + 1];
+
+	BuildChain(0, TailLength, ChainArray);
+	Sites.Reset(Length, ChainArray);
+
+	std::vector<HalfChain> Heads(HeadCodes.size());
+	std::vector<HalfChain> Tails(4 * TailCodes.size());
+
+	for (size_t i = 0; i < HeadCodes.size(); ++i)
+	{
+		BuildChain(HeadCodes[i], HeadLength, ChainArray);
+
+		Heads[i].EndSite = Sites.Site(ChainArray[HeadLength]);
+		Heads[i].LastSite = Sites.Site(ChainArray[HeadLength - 1]);
+		Heads[i].Code = HeadCodes[i];
+		Heads[i].Transform = 0;
+	}
+
+	for (size_t i = 0; i < TailCodes.size(); ++i)
+	{
+		BuildChain(TailCodes[i], TailLength, ChainArray);
+
+		for (int t = 1; t <= 4; ++t)
+		{
+			HalfChain &Tail = Tails[4 * i + t - 1];
+
+			Tail.EndSite = Sites.Site(TransformTail(ChainArray[TailLength], t));
+			Tail.LastSite = Sites.Site(TransformTail(ChainArray[TailLength - 1], t));
+			Tail.Code = TailCodes[i];
+			Tail.Transform = t;
+		}
+	}
+
+	std::vector<uint64>().swap(HeadCodes);
+	std::vector<uint64>().swap(TailCodes);
+
+	std::sort(Heads.begin(), Heads.end());
+	std::sort(Tails.begin(), Tails.end());
+
+/* Pairs of Buckets With the Same Final Site */
+	std::vector<size_t> HeadStart, TailStart;
+	size_t j = 0;
+
+	for (size_t i = 0; i < Heads.size(); )
+	{
+		size_t iEnd = i;
+		while ((iEnd < Heads.size()) && (Heads[iEnd].EndSite == Heads[i].EndSite))  ++iEnd;
+
+		while ((j < Tails.size()) && (Tails[j].EndSite < Heads[i].EndSite))  ++j;
+
+		if ((j < Tails.size()) && (Tails[j].EndSite == Heads[i].EndSite))
+		{
+			HeadStart.push_back(i);
+			TailStart.push_back(j);
+		}
+
+		i = iEnd;
+	}
+
+	delete[] ChainArray;
+
+	cout << "(" << Heads.size() << " heads, " << Tails.size() << " tails, " << HeadStart.size() << " buckets) ";
+
+/* *** Step #2:  Join Pairs in Each Bucket, Threads Take Buckets in Turn */
+	std::atomic<size_t> NextBucket(0);
+
+	RunInParallel(Job.NumberOfThreads, [&] (int ThreadID)
+	{
+		EnumerationTally &Tally = Job.Tally[ThreadID];
+
+		LatticeVector *Head = new LatticeVector [Length + 1];
+		LatticeVector *Tail = new LatticeVector [TailLength + 1];
+
+	/* Occupancy Map of Head (the fixed atoms 0, 1, 2 are marked once) */
+		OccupancyMap Map;
+		BuildChain(0, Length, Head);
+		Map.Reset(Length, Head);
+
+	/* Interior Sites of All Tails in Bucket, Starting Next to the Final Site */
+		std::vector<size_t> TailSites;
+
+		for (size_t b = NextBucket++; b < HeadStart.size(); b = NextBucket++)
+		{
+			size_t TailEnd = TailStart[b];
+			while ((TailEnd < Tails.size()) && (Tails[TailEnd].EndSite == Tails[TailStart[b]].EndSite))  ++TailEnd;
+
+			TailSites.clear();
+
+			for (size_t t = TailStart[b]; t < TailEnd; ++t)
+			{
+				BuildChain(Tails[t].Code, TailLength, Tail);
+
+				for (int k = TailLength - 1; k > 0; --k)  TailSites.push_back(Map.Site(TransformTail(Tail[k], Tails[t].Transform)));
+			}
+
+			for (size_t h = HeadStart[b]; (h < Heads.size()) && (Heads[h].EndSite == Heads[HeadStart[b]].EndSite); ++h)
+			{
+			/* Mark Interior Atoms of Head */
+				BuildChain(Heads[h].Code, HeadLength, Head);
+				for (int k = 3; k < HeadLength; ++k)  Map.Set(Head[k]);
+
+				for (size_t t = TailStart[b]; t < TailEnd; ++t)
+				{
+				/* Chain Must Not Reverse Direction at the Joint */
+					if (Tails[t].LastSite == Heads[h].LastSite)  continue;
+
+					++Tally.ChainChecks;
+
+				/* Check Interior Atoms of Tail for Overlaps With the Head */
+					const size_t *Site = &TailSites[(t - TailStart[b]) * (TailLength - 1)];
+					int k = 0;
+
+					while ((k < TailLength - 1) && (((Map.Bits[Site[k] >> 6] >> (Site[k] & 63)) & 1) == 0))  ++k;
+
+					if (k < TailLength - 1)  continue;
+
+				/* Found a Closed Chain:  Append Turns of the Tail (backwards) to the Code of the Head */
+					if (Length <= MaxCodeLength)
+					{
+						BuildChain(Tails[t].Code, TailLength, Tail);
+
+						for (int i = HeadLength + 1; i <= Length; ++i)  Head[i] = TransformTail(Tail[Length - i], Tails[t].Transform);
+
+						uint64 Code = Heads[h].Code;
+						int orientation = 1;
+
+						for (int i = 3; i <= HeadLength; ++i)
+						{
+							if ((Code & ((uint64)1 << (HeadLength - i))) == 0)
+								++orientation;
+							else
+								--orientation;
+						}
+
+						for (int i = HeadLength + 1; i <= Length; ++i)
+						{
+							LatticeVector Next = Head[i - 1];
+							Next.LeftTurn(orientation);
+
+							Code <<= 1;
+
+							if (Next == Head[i])
+							{
+								++orientation;
+							}
+							else
+							{
+								Code |= 1;
+								--orientation;
+							}
+						}
+
+						StorePolygon(ThreadID, Code, Job);
+					}
+
+					++Tally.ClosedChains;
+				}
+
+			/* Clear Head From Map */
+				for (int k = 3; k < HeadLength; ++k)  Map.Clear(Head[k]);
+			}
+		}
+
+		delete[] Head;
+		delete[] Tail;
+	});
+}
+
+/* *** TRANSFER MATRIX FOR POLYGONS *** */
+
+/* Polygons only, without enumeration:  the honeycomb lattice is drawn as a brick wall, a square grid with every
+   other vertical bond missing (bond (x, y) - (x, y + 1) present for x + y + Phase even).  Polygons are counted
+   by their bounding box.  A strip of Rows lattice rows is swept column by column, one site at a time, and the
+   bonds crossing the cut line form the boundary state:  for each bond, empty, lower end or upper end of an arc
+   of the partial polygon behind the cut (arcs nest like parentheses), together with flags for bottom and top
+   rows reached, and the number of bonds used.  Each state carries the number of partial polygons behind it.
+   A polygon is complete where the two ends of its last arc meet; it counts if it spans the strip from bottom
+   to top.  Polygons start in the first column, so that each is found once per bounding box.  Polygons wider
+   than high are counted in strips of the brick wall, the others in strips of the transposed brick wall (every
+   other horizontal bond missing), so that no strip needs more than Length / 4 + 1 rows.  States which cannot
+   be completed with the bonds left are dropped at once.  Both phases of the brick wall together give the
+   number of polygons per lattice cell (2 sites); a polygon of Length bonds then shows up as Length / 6 closed
+   chains from the origin (first bond to the right, first turn left).
+
+   The states are kept in a table of shards, as in the hash set mode.  In every step, the threads expand the
+   shards of the table in turn into per-thread buffers (one per target shard), releasing each shard when done,
+   and then merge the buffers shard by shard into the new table.  Every table and buffer is booked against a
+   memory budget before it is allocated, so that a step which would go past the limit stops at once, without
+   the allocation. */
+
+/* Widest Strip (rows), Bits per Bond in a Boundary State */
+const int MaxTransferRows = 26;
+const int BondBits = 2;
+
+/* Position of Flags (bottom, top row reached) and Number of Bonds in the Key of a Boundary State */
+const int FlagShift = 54;
+const int BondCountShift = 56;
+const uint64 BottomReached = (uint64)1 << FlagShift;
+const uint64 TopReached = (uint64)2 << FlagShift;
+const uint64 BoundaryMask = ((uint64)1 << FlagShift) - 1;
+
+class MemoryBudget
+{
+/* Memory Booked by Tables and Buffers (safe for concurrent use), Largest Amount Booked, Limit */
+public:
+	MemoryBudget (uint64 MemoryLimit)
+	{
+		Limit = MemoryLimit;
+		Live = 0;
+		Peak = 0;
+	}
+
+	bool Reserve (uint64 Bytes)
+	{
+	/* Book Memory Before Allocating It; Returns false (nothing booked) If the Limit Would Be Exceeded */
+		uint64 Total = (Live += Bytes);
+
+		if (Total > Limit)
+		{
+			Live -= Bytes;
+			return false;
+		}
+
+		uint64 Highest = Peak;
+		while ((Total > Highest) && !Peak.compare_exchange_weak(Highest, Total))  ;
+
+		return true;
+	}
+
+	void Return (uint64 Bytes)
+	{
+	/* Memory Freed */
+		Live -= Bytes;
+	}
+
+	uint64 PeakBytes (void)
+	{
+		return Peak;
+	}
+
+private:
+	uint64 Limit;
+	std::atomic<uint64> Live;
+	std::atomic<uint64> Peak;
+};
+
+class BoundaryTable
+{
+/* Boundary States of the Transfer Matrix, With Their Numbers of Partial Polygons
+   The table is split into shards by the leading bits of a hash value, each an open-addressing table with
+   linear probing; a shard is filled by one thread at a time, so that no locks are needed. */
+public:
+	static const int ShardBits = 8;
+	static const int NumberOfShards = (1 << ShardBits);
+
+/* Marks Unused Slots (keys never have the highest bit set) */
+	static const uint64 EmptySlot = ~(uint64)0;
+
+	struct Entry
+	{
+		uint64 Key;
+		uint64 Count;
+	};
+
+	struct Shard
+	{
+		Entry *Slots;
+		uint64 Capacity;
+		uint64 Count;
+	};
+
+	Shard Shards[NumberOfShards];
+
+	BoundaryTable (MemoryBudget &TableBudget) : Budget(TableBudget)
+	{
+	/* Constructor:  No Tables Yet, Memory Booked With a Budget */
+		for (int i = 0; i < NumberOfShards; ++i)
+		{
+			Shards[i].Slots = NULL;
+			Shards[i].Capacity = 0;
+			Shards[i].Count = 0;
+		}
+	}
+
+	~BoundaryTable ()
+	{
+		for (int i = 0; i < NumberOfShards; ++i)  Release(i);
+	}
+
+	static inline uint64 Hash (uint64 Key)
+	{
+	/* Fibonacci Hashing:  Leading Bits Select Shard, Following Bits Select Slot */
+		return Key * (uint64)0x9E3779B97F4A7C15ULL;
+	}
+
+	static inline int ShardOf (uint64 Key)
+	{
+		return (int)(Hash(Key) >> (64 - ShardBits));
+	}
+
+	bool Add (int i, uint64 Key, uint64 Count)
+	{
+	/* Add Partial Polygons to a State of Shard i (state is created if necessary)
+	   Returns false If the Shard Would Have to Grow Beyond the Memory Budget */
+		Shard &Target = Shards[i];
+
+	/* Keep Load Factor Below 1/2 */
+		if ((2 * (Target.Count + 1) > Target.Capacity) && !Grow(Target))  return false;
+
+		Entry *Slot = Find(Target, Key);
+
+		if (Slot->Key == EmptySlot)
+		{
+			Slot->Key = Key;
+			Slot->Count = 0;
+			++Target.Count;
+		}
+
+		Slot->Count += Count;
+		return true;
+	}
+
+	void Release (int i)
+	{
+	/* Return a Shard to the System */
+		delete[] Shards[i].Slots;
+		Budget.Return(Shards[i].Capacity * sizeof(Entry));
+
+		Shards[i].Slots = NULL;
+		Shards[i].Capacity = 0;
+		Shards[i].Count = 0;
+	}
+
+	uint64 Count (void)
+	{
+	/* Number of States in Table */
+		uint64 Total = 0;
+		for (int i = 0; i < NumberOfShards; ++i)  Total += Shards[i].Count;
+		return Total;
+	}
+
+	uint64 Bytes (void)
+	{
+	/* Memory Used by the Tables */
+		uint64 Total = 0;
+		for (int i = 0; i < NumberOfShards; ++i)  Total += Shards[i].Capacity * sizeof(Entry);
+		return Total;
+	}
+
+private:
+	MemoryBudget &Budget;
+
+	static Entry *Find (Shard &Target, uint64 Key)
+	{
+	/* Linear Probing From Home Slot:  Slot of the Key, or Empty Slot Where It Belongs */
+		uint64 Mask = Target.Capacity - 1;
+		uint64 Slot = (Hash(Key) >> ShardBits) & Mask;
+
+		while ((Target.Slots[Slot].Key != EmptySlot) && (Target.Slots[Slot].Key != Key))  Slot = (Slot + 1) & Mask;
+
+		return &Target.Slots[Slot];
+	}
+
+	bool Grow (Shard &Target)
+	{
+	/* Double Table Size (at least 64 slots), Re-Insert All States; Returns false If Out of Budget */
+		Shard Old = Target;
+		uint64 NewCapacity = (Old.Capacity > 0) ? 2 * Old.Capacity : 64;
+
+		if (!Budget.Reserve(NewCapacity * sizeof(Entry)))  return false;
+
+		Target.Capacity = NewCapacity;
+		Target.Slots = new Entry [(size_t)Target.Capacity];
+		for (uint64 j = 0; j < Target.Capacity; ++j)  Target.Slots[j].Key = EmptySlot;
+
+		for (uint64 j = 0; j < Old.Capacity; ++j)
+		{
+			if (Old.Slots[j].Key != EmptySlot)  *Find(Target, Old.Slots[j].Key) = Old.Slots[j];
+		}
+
+		delete[] Old.Slots;
+		Budget.Return(Old.Capacity * sizeof(Entry));
+
+		return true;
+	}
+};
+
+struct TransferStrip
+{
+/* Strip of the Brick Wall (or of the transposed brick wall) Swept by the Transfer Matrix */
+	int Rows;
+	int Phase;
+	bool Transposed;
+
+/* Polygons Count From This Column on (width at least the height of the strip, or more) */
+	int FirstColumn;
+
+	inline bool HasRightBond (int x, int y) const
+	{
+	/* Bond (x, y) - (x + 1, y) */
+		return !Transposed || (((x + y + Phase) & 1) == 0);
+	}
+
+	inline bool HasUpperBond (int x, int y) const
+	{
+	/* Bond (x, y) - (x, y + 1), Within the Strip */
+		return (y + 1 < Rows) && (Transposed || (((x + y + Phase) & 1) == 0));
+	}
+};
+
+inline int BondAt (uint64 Key, int Position)
+{
+/* Bond Crossing the Cut Line (0: empty, 1: lower end of an arc, 2: upper end) */
+	return (int)((Key >> (BondBits * Position)) & 3);
+}
+
+inline uint64 SetBond (uint64 Key, int Position, int Bond)
+{
+	return (Key & ~((uint64)3 << (BondBits * Position))) | ((uint64)Bond << (BondBits * Position));
+}
+
+inline int PartnerAbove (uint64 Key, int Position, int Rows)
+{
+/* Upper End of the Arc Starting at a Lower End */
+	int Depth = 0;
+
+	for (int p = Position; p <= Rows; ++p)
+	{
+		int Bond = BondAt(Key, p);
+
+		if (Bond == 1)  ++Depth;
+		if ((Bond == 2) && (--Depth == 0))  return p;
+	}
+
+	return -1;
+}
+
+inline int PartnerBelow (uint64 Key, int Position)
+{
+/* Lower End of the Arc Ending at an Upper End */
+	int Depth = 0;
+
+	for (int p = Position; p >= 0; --p)
+	{
+		int Bond = BondAt(Key, p);
+
+		if (Bond == 2)  ++Depth;
+		if ((Bond == 1) && (--Depth == 0))  return p;
+	}
+
+	return -1;
+}
+
+inline int BondsStillNeeded (uint64 Key, int x, int y, const TransferStrip &Strip)
+{
+/* Lower Bound on the Bonds Needed to Complete the Polygon, After Site (x, y)
+   (cut line:  right bonds of rows 0 ... y at positions 0 ... y, bond up from row y at y + 1, left bonds of
+   rows y + 1 ... at positions y + 2 ...) */
+	int Lowest = -1, Highest = -1;
+	int Ends = 0, Needed = 0;
+
+	for (int p = 0; p <= Strip.Rows; ++p)
+	{
+		if (BondAt(Key, p) == 0)  continue;
+
+		int Row = (p <= y) ? p : ((p == y + 1) ? y + 1 : p - 1);
+		if (Lowest < 0)  Lowest = Row;
+		Highest = Row;
+
+	/* Loose Ends Are Joined in Pairs:  Vertical Bonds Between Neighboring Ends (first with second, ...) */
+		Needed += ((Ends++ & 1) == 0) ? -Row : Row;
+	}
+
+/* Empty State (first column only):  Anything Goes */
+	if (Lowest < 0)  return 0;
+
+/* Way Down to the Bottom Row and Back, Up to the Top Row and Back, Crossings of Columns Still to Reach */
+	if ((Key & BottomReached) == 0)  Needed += 2 * Lowest;
+	if ((Key & TopReached) == 0)  Needed += 2 * (Strip.Rows - 1 - Highest);
+	if (x < Strip.FirstColumn - 1)  Needed += 2 * (Strip.FirstColumn - 1 - x);
+
+	return Needed;
+}
+
+bool CountStripPolygons (const TransferStrip &Strip, int Length, int NumberOfThreads, uint64 MemoryLimit,
+						 uint64 &Polygons, uint64 &States, uint64 &PeakBytes)
+{
+/* Count the Polygons of Length Bonds That Span the Strip From Bottom to Top, Starting in Column 0
+   Function Value Returned is false If Memory Runs Out; Largest Table, Peak Memory So Far Are Updated */
+	const int Rows = Strip.Rows;
+	const int Shards = BoundaryTable::NumberOfShards;
+	const uint64 EntryBytes = sizeof(BoundaryTable::Entry);
+
+/* All Tables and Buffers Are Booked Against the Limit Before They Are Allocated */
+	MemoryBudget Budget(MemoryLimit);
+
+	BoundaryTable *Current = new BoundaryTable(Budget);
+	bool IsWithinLimit = Current->Add(BoundaryTable::ShardOf(0), 0, 1);
+
+	std::vector<uint64> Found(NumberOfThreads, 0);
+	std::vector<std::vector<BoundaryTable::Entry> > Outgoing((size_t)NumberOfThreads * Shards);
+	std::atomic<bool> IsOutOfMemory(!IsWithinLimit);
+
+	for (int x = 0; (Current->Count() > 0) && IsWithinLimit; ++x)
+	{
+		for (int y = 0; (y < Rows) && IsWithinLimit; ++y)
+		{
+		/* *** Step #1:  Expand All States Over Site (x, y), Shard by Shard */
+			std::atomic<int> NextShard(0);
+
+			RunInParallel(NumberOfThreads, [&] (int ThreadID)
+			{
+				std::vector<BoundaryTable::Entry> *Buffers = &Outgoing[(size_t)ThreadID * Shards];
+				int i;
+
+				auto Emit = [&] (uint64 Key, uint64 Count)
+				{
+					if ((int)(Key >> BondCountShift) + BondsStillNeeded(Key, x, y, Strip) > Length)  return;
+
+					BoundaryTable::Entry Next = {Key, Count};
+					std::vector<BoundaryTable::Entry> &Buffer = Buffers[BoundaryTable::ShardOf(Key)];
+
+				/* Full Buffer:  Book Twice the Room First */
+					if (Buffer.size() == Buffer.capacity())
+					{
+						size_t Room = (Buffer.capacity() > 0) ? 2 * Buffer.capacity() : 64;
+
+						if (!Budget.Reserve(Room * EntryBytes))
+						{
+							IsOutOfMemory = true;
+							return;
+						}
+
+						Budget.Return(Buffer.capacity() * EntryBytes);
+						Buffer.reserve(Room);
+					}
+
+					Buffer.push_back(Next);
+				};
+
+				while (!IsOutOfMemory && ((i = NextShard++) < Shards))
+				{
+					const BoundaryTable::Shard &Source = Current->Shards[i];
+
+					for (uint64 j = 0; (j < Source.Capacity) && !IsOutOfMemory; ++j)
+					{
+						uint64 Key = Source.Slots[j].Key;
+						uint64 Count = Source.Slots[j].Count;
+						if (Key == BoundaryTable::EmptySlot)  continue;
+
+					/* New Column:  Left Bonds of Rows Move Up One Position, Behind the (empty) Bond From Below */
+						if (y == 0)
+						{
+						/* Polygons Start in Column 0:  No Empty State Later On */
+							if ((x > 0) && ((Key & BoundaryMask) == 0))  continue;
+
+							Key = (Key & ~BoundaryMask) | ((Key & BoundaryMask) << BondBits);
+						}
+
+						int Below = BondAt(Key, y);
+						int Left = BondAt(Key, y + 1);
+
+						uint64 Base = SetBond(SetBond(Key, y, 0), y + 1, 0);
+						uint64 Touch = ((y == 0) ? BottomReached : 0) | ((y == Rows - 1) ? TopReached : 0);
+						uint64 OneBond = (uint64)1 << BondCountShift;
+
+						bool HasRight = Strip.HasRightBond(x, y);
+						bool HasUp = Strip.HasUpperBond(x, y);
+
+						if ((Below == 0) && (Left == 0))
+						{
+						/* Empty Site, or Start of a New Arc */
+							Emit(Base, Count);
+							if (HasRight && HasUp)  Emit((SetBond(SetBond(Base, y, 1), y + 1, 2) + 2 * OneBond) | Touch, Count);
+						}
+						else if ((Below == 0) || (Left == 0))
+						{
+						/* Arc Goes On to the Right or Upward */
+							int Bond = Below + Left;
+
+							if (HasRight)  Emit((SetBond(Base, y, Bond) + OneBond) | Touch, Count);
+							if (HasUp)  Emit((SetBond(Base, y + 1, Bond) + OneBond) | Touch, Count);
+						}
+						else if ((Below == 1) && (Left == 1))
+						{
+						/* Two Lower Ends Join:  Upper End of the Upper Arc Becomes a Lower End */
+							Emit(SetBond(Base, PartnerAbove(Key, y + 1, Rows), 1) | Touch, Count);
+						}
+						else if ((Below == 2) && (Left == 2))
+						{
+						/* Two Upper Ends Join:  Lower End of the Lower Arc Becomes an Upper End */
+							Emit(SetBond(Base, PartnerBelow(Key, y), 2) | Touch, Count);
+						}
+						else if ((Below == 2) && (Left == 1))
+						{
+						/* Two Arcs Join */
+							Emit(Base | Touch, Count);
+						}
+						else
+						{
+						/* Both Ends of One Arc Meet:  Polygon Complete If Nothing Else Is Left */
+							Base |= Touch;
+
+							if (((Base & BoundaryMask) == 0) && ((Base & (BottomReached | TopReached)) == (BottomReached | TopReached))
+								&& ((int)(Base >> BondCountShift) == Length) && (x >= Strip.FirstColumn))
+								Found[ThreadID] += Count;
+						}
+					}
+
+					Current->Release(i);
+				}
+			});
+
+		/* *** Step #2:  Merge Buffers Into New Table, Shard by Shard (buffers are released as they are merged) */
+			BoundaryTable *Next = new BoundaryTable(Budget);
+			NextShard = 0;
+
+			RunInParallel(NumberOfThreads, [&] (int)
+			{
+				int i;
+
+				while (!IsOutOfMemory && ((i = NextShard++) < Shards))
+				{
+					for (int t = 0; (t < NumberOfThreads) && !IsOutOfMemory; ++t)
+					{
+						std::vector<BoundaryTable::Entry> &Buffer = Outgoing[(size_t)t * Shards + i];
+
+						for (size_t j = 0; j < Buffer.size(); ++j)
+						{
+							if (!Next->Add(i, Buffer[j].Key, Buffer[j].Count))
+							{
+								IsOutOfMemory = true;
+								break;
+							}
+						}
+
+						Budget.Return(Buffer.capacity() * EntryBytes);
+						std::vector<BoundaryTable::Entry>().swap(Buffer);
+					}
+				}
+			});
+
+			delete Current;
+			Current = Next;
+
+			uint64 Count = Current->Count();
+			if (Count > States)  States = Count;
+
+			if (IsOutOfMemory)  IsWithinLimit = false;
+		}
+	}
+
+/* Buffers Left Over by a Step Stopped for Lack of Memory */
+	for (size_t b = 0; b < Outgoing.size(); ++b)  Budget.Return(Outgoing[b].capacity() * EntryBytes);
+	std::vector<std::vector<BoundaryTable::Entry> >().swap(Outgoing);
+
+	delete Current;
+
+	if (Budget.PeakBytes() > PeakBytes)  PeakBytes = Budget.PeakBytes();
+
+	for (int t = 0; t < NumberOfThreads; ++t)  Polygons += Found[t];
+
+	return IsWithinLimit;
+}
+
+bool CountPolygonsByTransferMatrix (int Length, int NumberOfThreads, uint64 MemoryLimit, uint64 &ClosedChains,
+									uint64 &States, uint64 &PeakBytes)
+{
+/* Number of Closed Self-Avoiding Chains of a Length (as found by the enumeration), From Polygons per Lattice Cell
+   Function Value Returned is false If Memory Runs Out; Largest Table (states), Peak Memory */
+	uint64 Polygons = 0;
+	bool IsWithinLimit = true;
+
+	ClosedChains = 0;
+	States = 0;
+	PeakBytes = 0;
+
+/* Honeycomb Lattice is Bipartite:  Polygons Have an Even Number of Bonds */
+	if ((Length < 6) || ((Length & 1) != 0))  return true;
+
+	for (int Rows = 2; (4 * (Rows - 1) <= Length) && (Rows <= MaxTransferRows) && IsWithinLimit; ++Rows)
+	{
+		for (int Phase = 0; Phase <= 1; ++Phase)
+		{
+		/* Polygons at Least as Wide as High in the Brick Wall, Higher Ones (wider in the transposed wall) */
+			TransferStrip Wide = {Rows, Phase, false, Rows - 1};
+			TransferStrip High = {Rows, Phase, true, Rows};
+
+			if (IsWithinLimit)  IsWithinLimit = CountStripPolygons(Wide, Length, NumberOfThreads, MemoryLimit, Polygons, States, PeakBytes);
+			if (IsWithinLimit)  IsWithinLimit = CountStripPolygons(High, Length, NumberOfThreads, MemoryLimit, Polygons, States, PeakBytes);
+		}
+	}
+
+	ClosedChains = (Polygons * Length) / 6;
+
+	return IsWithinLimit;
+}
+
+/* *** ENGINES SPECIALIZED ON CHAIN LENGTH *** */
+
+/* Both range engines are templates on the number of segments N.  In an instance with N > 0, the chain length is
+   a compile-time constant in all the inline chain functions (BuildChain, RebuildChain, ChainOverlap, ...), so
+   the compiler knows loop limits and shift amounts.  The instances for MinFixedLength ... MaxFixedLength segments
+   are collected in a table on first use, and each thread picks its engine there once; other lengths use the
+   generic instance N = 0. */
+
+const int MinFixedLength = 20;
+const int MaxFixedLength = 62;
+
+typedef void (*RangeEngine) (int ThreadID, CodeRange Range, LatticeVector *ChainArray, OccupancyMap &Map, EnumerationTally &Tally, EnumerationJob &Job);
+
+struct EngineTable
+{
+/* Specialized Engines by Chain Length (index: length - MinFixedLength) */
+	RangeEngine ByCode[MaxFixedLength - MinFixedLength + 1];
+	RangeEngine DepthFirst[MaxFixedLength - MinFixedLength + 1];
+};
+
+template <int N>
+struct EngineInstances
+{
+	static void Fill (EngineTable &Table)
+	{
+	/* Enter Instances for N Segments, Continue With N - 1 */
+		Table.ByCode[N - MinFixedLength] = EnumerateRange<N>;
+		Table.DepthFirst[N - MinFixedLength] = EnumerateRangeDepthFirst<N>;
+
+		EngineInstances<N - 1>::Fill(Table);
+	}
+};
+
+template <>
+struct EngineInstances<MinFixedLength - 1>
+{
+	static void Fill (EngineTable &)
+	{
+	/* All Instances Entered */
+	}
+};
+
+EngineTable MakeEngineTable (void)
+{
+/* Collect All Specialized Engines */
+	EngineTable Table;
+	EngineInstances<MaxFixedLength>::Fill(Table);
+
+	return Table;
+}
+
+RangeEngine SelectRangeEngine (EnumerationJob &Job)
+{
+/* Find Engine for the Chains of a Job:  Specialized Instance If Available, Generic Instance Otherwise */
+	static const EngineTable Table = MakeEngineTable();
+
+	bool IsFixed = Job.Specialized && (Job.Length >= MinFixedLength) && (Job.Length <= MaxFixedLength);
+
+	if (Job.Engine == EngineDepthFirst)
+		return IsFixed ? Table.DepthFirst[Job.Length - MinFixedLength] : EnumerateRangeDepthFirst<0>;
+	else
+		return IsFixed ? Table.ByCode[Job.Length - MinFixedLength] : EnumerateRange<0>;
+}
+
+bool FetchRange (int ThreadID, EnumerationJob &Job, CodeRange &Range)
+{
+/* Find Next Code Range for a Thread:  Own Queue First, Then Steal From Other Threads */
+
+	if (Job.Queues[ThreadID].Pop(Range))  return true;
+
+	for (int i = 1; i < Job.NumberOfThreads; ++i)
+	{
+		int Victim = (ThreadID + i) % Job.NumberOfThreads;
+
+		if (Job.Queues[Victim].Steal(Range))  return true;
+	}
+
+/* All Work Done */
+	return false;
+}
+
+void EnumerationWorker (int ThreadID, EnumerationJob *Job, EnumerationTally *Tally)
+{
+/* Thread Main Function:  Evaluate Code Ranges Until No Work Is Left */
+
+/* Private Storage Array for Atom Coordinates */
+	std::array<LatticeVector, MaxChainLength + 1> ChainArray;
+
+/* Private Occupancy Map (bitmap overlap check, depth-first engine) */
+	OccupancyMap Map;
+
+/* Engine for Chains of This Length */
+	RangeEngine Engine = SelectRangeEngine(*Job);
+
+	CodeRange Range;
+	COUNT(StartCounters());
+
+	while (FetchRange(ThreadID, *Job, Range))
+	{
+		Engine(ThreadID, Range, ChainArray.data(), Map, *Tally, *Job);
+	}
+
+/* Add Counters to Totals of the Job */
+	COUNT(std::lock_guard<std::mutex> Guard(Job->ReportLock); Job->Counters.Add(ThreadCounters));
+
+/* No Longer Take Part in Checkpoints */
+	if (Job->Checkpoint != NULL)  Job->Checkpoint->Retire(ThreadID, *Job);
+}
+
+/* *** SWEEPS OVER CHAIN LENGTHS *** */
+
+/* A sweep runs a range of chain lengths in one go.  Finished lengths go into a results table (a text file with
+   one line per length), and a length found in the table is reported from there instead of being computed again.
+   The frontier cache keeps the live prefixes of length P = n - K, i.e. the codes of all chains of P segments
+   without overlaps, as a bitmap on disk (one file per prefix length).  Chains of length n only need the code
+   ranges behind these prefixes, so that no prefix known to be dead is entered again. */
+
+struct RunOptions
+{
+/* Settings Shared by All Chain Lengths of a Run */
+	int NumberOfThreads;
+	int PrefixBits;
+	const _TCHAR *CheckpointFile;
+	time_t CheckpointInterval;
+	const _TCHAR *ResumeFile;
+	const _TCHAR *StreamPrefix;
+	uint64 RunBufferSize;
+	PolygonStorage Storage;
+	OverlapEngine Overlap;
+	EnumerationEngine Engine;
+	bool Specialized;
+	int TailBits;
+	bool Reversal;
+
+/* File Name Prefix of the Frontier Cache (NULL: none), Distance K of Prefixes From Full Length */
+	const _TCHAR *FrontierPrefix;
+	int FrontierDepth;
+
+/* File Name Prefix of Polygon Catalogs (NULL: none), Symmetry Byte for Each Polygon */
+	const _TCHAR *CatalogPrefix;
+	bool CatalogSymmetry;
+
+/* Statistics of Open Chains */
+	bool ChainStatistics;
+
+/* Sort Polygons Within Their Storage (memory mode only) */
+	bool InPlaceSort;
+
+/* Memory Limit of the Transfer Matrix (in MB) */
+	uint64 TransferMemory;
+};
+
+struct LengthResults
+{
+/* Results for One Chain Length (chain counts not determined by half-chain join,
+   polygons not determined beyond 64-bit codes) */
+	int Length;
+	bool HasChains;
+	bool HasPolygons;
+	uint64 NonOverlaps;
+	uint64 ClosedChains;
+	uint64 UniquePolygons;
+	SymmetryCensus Census;
+
+/* Evaluations Performed, Size of the Code Space */
+	uint64 ChainChecks;
+	uint64 CodeSpace;
+
+/* Time Spent on Enumeration and on Analysis of Polygons (in seconds), Phases of the Analysis, Taken From Results Table */
+	double EnumerationSeconds;
+	double AnalysisSeconds;
+	AnalysisTimes Phases;
+	bool FromTable;
+
+/* Statistics of Open Chains (if gathered) */
+	bool HasStatistics;
+	ChainStatistics Statistics;
+};
+
+/* Limits on Prefixes Kept in the Frontier Cache (bitmap of 2^(P-2) bits) */
+const int MinFrontierLength = 8;
+const int MaxFrontierLength = 26;
+
+/* File Identification */
+const char FrontierMagic[8] = {'2', 'D', 'C', 'F', 'R', 'N', 'T', '1'};
+
+void ReadResultsTable (const _TCHAR *FileName, std::map<int, LengthResults> &Table)
+{
+/* Load All Lengths Finished Before (missing table:  no lengths; lines starting with # are comments) */
+
+	FILE *File = _tfopen(FileName, _T("r"));
+	if (File == NULL)  return;
+
+	char Line[512];
+
+	while (fgets(Line, sizeof(Line), File) != NULL)
+	{
+		int Length;
+		unsigned long long Value[11];
+
+		if (sscanf(Line, "%d %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu", &Length,
+				   &Value[0], &Value[1], &Value[2], &Value[3], &Value[4], &Value[5],
+				   &Value[6], &Value[7], &Value[8], &Value[9], &Value[10]) != 12)  continue;
+
+		LengthResults &Entry = Table[Length];
+		Entry.Length = Length;
+		Entry.HasChains = true;
+		Entry.HasPolygons = true;
+		Entry.NonOverlaps = Value[0];
+		Entry.ClosedChains = Value[1];
+		Entry.UniquePolygons = Value[2];
+		Entry.Census.SC1 = Value[3];
+		Entry.Census.SC1m = Value[4];
+		Entry.Census.SC2 = Value[5];
+		Entry.Census.SC2m = Value[6];
+		Entry.Census.SC3 = Value[7];
+		Entry.Census.SC3m = Value[8];
+		Entry.Census.SC6 = Value[9];
+		Entry.Census.SC6m = Value[10];
+		Entry.ChainChecks = 0;
+		Entry.CodeSpace = 0;
+		Entry.EnumerationSeconds = 0;
+		Entry.AnalysisSeconds = 0;
+		Entry.Phases.Reduce = Entry.Phases.Sort = Entry.Phases.Census = 0;
+		Entry.FromTable = true;
+		Entry.HasStatistics = false;
+	}
+
+	fclose(File);
+}
+
+bool AppendResultsTable (const _TCHAR *FileName, const LengthResults &Results)
+{
+/* Add a Finished Length to the Results Table (header line for a new table) */
+
+	FILE *File = _tfopen(FileName, _T("a"));
+	if (File == NULL)  return false;
+
+	fseek(File, 0, SEEK_END);
+	if (ftell(File) == 0)
+		fprintf(File, "# Segments  Chains  Closed-Loops  Polygons  1  1m  2  2m  3  3m  6  6m\n");
+
+	const SymmetryCensus &Census = Results.Census;
+
+	fprintf(File, "%d %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu\n", Results.Length,
+			(unsigned long long)Results.NonOverlaps, (unsigned long long)Results.ClosedChains,
+			(unsigned long long)Results.UniquePolygons,
+			(unsigned long long)Census.SC1, (unsigned long long)Census.SC1m,
+			(unsigned long long)Census.SC2, (unsigned long long)Census.SC2m,
+			(unsigned long long)Census.SC3, (unsigned long long)Census.SC3m,
+			(unsigned long long)Census.SC6, (unsigned long long)Census.SC6m);
+
+	bool Success = (ferror(File) == 0);
+	if (fclose(File) != 0)  Success = false;
+
+	return Success;
+}
+
+void CollectFrontier (int Prefix, std::vector<uint64> &Live)
+{
+/* Mark the Codes of All Chains of Prefix Segments Without Overlaps (one bit per code) */
+
+	uint64 MaxCode = ((uint64)1 << CodeBits(Prefix));
+	Live.assign((size_t)((MaxCode + 63) >> 6), 0);
+
+	LatticeVector ChainArray[MaxChainLength + 1];
+
+	uint64 Code = 0;
+	BuildChain(Code, Prefix, ChainArray);
+	uint64 LastCode = Code ^ (MaxCode >> 1);
+
+	while (Code < MaxCode)
+	{
+		int Segment = BranchingSegment(Code, LastCode, Prefix);
+		RebuildChain(Code, Segment, Prefix, ChainArray);
+		int OverlapAt = ChainOverlap(Segment, Prefix, ChainArray);
+
+		LastCode = Code;
+
+		if (OverlapAt == 0)
+		{
+			Live[(size_t)(Code >> 6)] |= (uint64)1 << (Code & 63);
+			++Code;
+		}
+		else
+		{
+		/* Smart Jump Past All Chains With This Overlap */
+			Code >>= (Prefix - OverlapAt);
+			++Code;
+			Code <<= (Prefix - OverlapAt);
+		}
+	}
+}
+
+bool LoadFrontier (const _TCHAR *FilePrefix, int Prefix, std::vector<uint64> &Live)
+{
+/* Live Prefixes From the Cache, or Collected and Added to the Cache (function value:  taken from cache) */
+
+	std::basic_ostringstream<_TCHAR> Name;
+	Name << FilePrefix << _T(".frontier") << std::setw(2) << std::setfill(_T('0')) << Prefix;
+	std::basic_string<_TCHAR> FileName = Name.str();
+
+	size_t Words = (size_t)((((uint64)1 << CodeBits(Prefix)) + 63) >> 6);
+
+/* Cached Bitmap:  Identification, Prefix Length, Number of Words, Words */
+	FILE *File = _tfopen(FileName.c_str(), _T("rb"));
+
+	if (File != NULL)
+	{
+		char Magic[sizeof(FrontierMagic)];
+		int Length = 0;
+		uint64 Count = 0;
+
+		Live.resize(Words);
+
+		bool Success = (fread(Magic, sizeof(Magic), 1, File) == 1)
+			&& (memcmp(Magic, FrontierMagic, sizeof(Magic)) == 0)
+			&& (fread(&Length, sizeof(int), 1, File) == 1) && (Length == Prefix)
+			&& (fread(&Count, sizeof(uint64), 1, File) == 1) && (Count == Words)
+			&& (fread(&Live[0], sizeof(uint64), Words, File) == Words);
+
+		fclose(File);
+		if (Success)  return true;
+
+		cerr << "WARNING:  Frontier cache file is damaged, collecting prefixes again\n";
+	}
+
+/* Not Cached Yet */
+	CollectFrontier(Prefix, Live);
+
+	File = _tfopen(FileName.c_str(), _T("wb"));
+
+	if (File != NULL)
+	{
+		uint64 Count = Words;
+
+		fwrite(FrontierMagic, sizeof(FrontierMagic), 1, File);
+		fwrite(&Prefix, sizeof(int), 1, File);
+		fwrite(&Count, sizeof(uint64), 1, File);
+		fwrite(&Live[0], sizeof(uint64), Words, File);
+
+		if ((ferror(File) != 0) | (fclose(File) != 0))  File = NULL;
+	}
+
+	if (File == NULL)  cerr << "WARNING:  Could not write frontier cache file\n";
+
+	return false;
+}
+
+uint64 SeedFromFrontier (const std::vector<uint64> &Live, int Prefix, int Length, std::vector<CodeRange> &Pending)
+{
+/* Code Ranges Behind Runs of Live Prefixes (function value:  number of live prefixes) */
+
+	uint64 PrefixCodes = ((uint64)1 << CodeBits(Prefix));
+	int Shift = Length - Prefix;
+	uint64 LivePrefixes = 0;
+
+	Pending.clear();
+
+	for (uint64 Code = 0; Code < PrefixCodes; )
+	{
+	/* Skip Dead Prefixes, Then Find End of Run */
+		if ((Live[(size_t)(Code >> 6)] & ((uint64)1 << (Code & 63))) == 0)
+		{
+			++Code;
+			continue;
+		}
+
+		uint64 First = Code;
+		while ((Code < PrefixCodes) && ((Live[(size_t)(Code >> 6)] & ((uint64)1 << (Code & 63))) != 0))  ++Code;
+
+		CodeRange Range = {First << Shift, Code << Shift};
+		Pending.push_back(Range);
+		LivePrefixes += Code - First;
+	}
+
+	return LivePrefixes;
+}
+
+void WriteResultsFile (const _TCHAR *FileName, bool AsCSV, const std::vector<LengthResults> &Records)
+{
+/* Machine-Readable Results of All Lengths of the Run (JSON array of records, or CSV with header line)
+   Counts Not Determined and Timings of Lengths Taken From the Results Table Are Left Empty (null) */
+
+	FILE *File = _tfopen(FileName, _T("w"));
+	if (File == NULL)
+	{
+		cerr << "WARNING:  Could not write results file\n";
+		return;
+	}
+
+	const char *Empty = AsCSV ? "" : "null";
+	const char *Names[17] = {"Length", "NonOverlaps", "ClosedChains", "UniquePolygons",
+							 "SC1", "SC1m", "SC2", "SC2m", "SC3", "SC3m", "SC6", "SC6m",
+							 "EnumerationSeconds", "AnalysisSeconds", "Source",
+							 "MeanSquaredEndToEnd", "MeanSquaredGyration"};
+
+	if (AsCSV)
+	{
+		for (int k = 0; k < 17; ++k)  fprintf(File, (k == 0) ? "%s" : ",%s", Names[k]);
+		fprintf(File, "\n");
+	}
+	else
+	{
+		fprintf(File, "[\n");
+	}
+
+	for (size_t i = 0; i < Records.size(); ++i)
+	{
+		const LengthResults &Results = Records[i];
+		const SymmetryCensus &Census = Results.Census;
+
+	/* Fields as Text, in the Order of Names */
+		char Field[17][32];
+		uint64 Classes[8] = {Census.SC1, Census.SC1m, Census.SC2, Census.SC2m, Census.SC3, Census.SC3m, Census.SC6, Census.SC6m};
+
+		sprintf(Field[0], "%d", Results.Length);
+		sprintf(Field[1], "%llu", (unsigned long long)Results.NonOverlaps);
+		sprintf(Field[2], "%llu", (unsigned long long)Results.ClosedChains);
+		sprintf(Field[3], "%llu", (unsigned long long)Results.UniquePolygons);
+		for (int k = 0; k < 8; ++k)  sprintf(Field[4 + k], "%llu", (unsigned long long)Classes[k]);
+		sprintf(Field[12], "%.3f", Results.EnumerationSeconds);
+		sprintf(Field[13], "%.3f", Results.AnalysisSeconds);
+		sprintf(Field[14], AsCSV ? "%s" : "\"%s\"", Results.FromTable ? "table" : "computed");
+		strcpy(Field[15], Empty);
+		strcpy(Field[16], Empty);
+
+		if (Results.HasStatistics && (Results.Statistics.Chains > 0))
+		{
+			const ChainStatistics &Statistics = Results.Statistics;
+			double Atoms = Results.Length + 1.0;
+
+			sprintf(Field[15], "%.10g", (double)Statistics.SquaredEndToEnd / Statistics.Chains);
+			sprintf(Field[16], "%.10g", (double)Statistics.SquaredGyration / (Atoms * Atoms * Statistics.Chains));
+		}
+
+		if (!Results.HasChains)  strcpy(Field[1], Empty);
+		if (!Results.HasPolygons)
+		{
+			for (int k = 3; k < 12; ++k)  strcpy(Field[k], Empty);
+		}
+		if (Results.FromTable)
+		{
+			strcpy(Field[12], Empty);
+			strcpy(Field[13], Empty);
+		}
+
+		if (AsCSV)
+		{
+			for (int k = 0; k < 17; ++k)  fprintf(File, (k == 0) ? "%s" : ",%s", Field[k]);
+			fprintf(File, "\n");
+		}
+		else
+		{
+			fprintf(File, "  {");
+			for (int k = 0; k < 17; ++k)  fprintf(File, "%s\"%s\": %s", (k == 0) ? "" : ", ", Names[k], Field[k]);
+			fprintf(File, (i + 1 < Records.size()) ? "},\n" : "}\n");
+		}
+	}
+
+	if (!AsCSV)  fprintf(File, "]\n");
+
+	if ((ferror(File) != 0) | (fclose(File) != 0))  cerr << "WARNING:  Could not write results file\n";
+}
+
+void PrintResults (const LengthResults &Results)
+{
+/* Display Final Results */
+	cout << "\n *** RESULTS for Chains on 2D Honeycomb Lattice with " << Results.Length << " Segments:\n\n";
+
+/* Number of Non-Overlapping Chains */
+	if (!Results.HasChains)
+		cout << "Number of Non-Overlapping Chains: Not Determined (half-chain join and transfer matrix find polygons only)\n\n";
+	else
+		cout << "Number of Non-Overlapping Chains: " << Results.NonOverlaps << "\n\n";
+
+/* Number of Closed-Loop Chains */
+	cout << "Number of Closed-Loop Chains: " << Results.ClosedChains << "\n\n";
+
+/* Unique Polygons, Symmetry Classes (only if polygon codes fit into 64 bits) */
+	if (!Results.HasPolygons)
+	{
+		cout << "Unique Polygons and Symmetry Classes Not Determined (polygon codes need more than 64 bits, or polygons counted by transfer matrix)\n\n";
+	}
+	else
+	{
+		const SymmetryCensus &Census = Results.Census;
+
+	/* Number of Unique Polygons */
+		cout << "Number of Unique Polygons: " << Results.UniquePolygons << " (includes mirror symmetric pairs)\n\n";
+
+	/* Specify Polygons By Symmetry Class: */
+		cout << "Self-Avoiding Polygon(s) By Symmetry Class: \n\n";
+
+		cout << "Class 1  (trivial symmetry group) ............... " << Census.SC1 << "\n"
+			 << "Class 1m (only mirror symmetry) ................. " << Census.SC1m << "\n"
+			 << "Class 2  (symmetry under 180 deg rotations) ..... " << Census.SC2 << "\n"
+			 << "Class 2m (180 deg rotation & mirror symmetry) ... " << Census.SC2m << "\n"
+			 << "Class 3  (symmetry under 120 deg rotations) ..... " << Census.SC3 << "\n"
+			 << "Class 3m (120 deg rotation & mirror symmetry) ... " << Census.SC3m << "\n"
+			 << "Class 6  (symmetry under 60 deg rotations) ...... " << Census.SC6 << "\n"
+			 << "Class 6m (60 deg rotation & mirror symmetry) .... " << Census.SC6m << "\n\n";
+	}
+
+/* Statistics of Open Chains */
+	if (Results.HasStatistics && (Results.Statistics.Chains > 0))
+	{
+		const ChainStatistics &Statistics = Results.Statistics;
+		double Atoms = Results.Length + 1.0;
+
+		cout << "Statistics of Non-Overlapping Chains (bond length = 1): \n\n"
+			 << "Mean Squared End-to-End Distance ............... " << (double)Statistics.SquaredEndToEnd / Statistics.Chains << "\n"
+			 << "Mean Squared Radius of Gyration ................ " << (double)Statistics.SquaredGyration / (Atoms * Atoms * Statistics.Chains) << "\n\n"
+			 << "End-to-End Distance (lattice metric): Chains \n";
+
+		for (int k = 0; k <= MaxChainLength; ++k)
+		{
+			if (Statistics.EndToEnd[k] > 0)  cout << std::setw(4) << k << ": " << Statistics.EndToEnd[k] << "\n";
+		}
+
+		cout << "\n";
+	}
+}
+
+void EnumerateLength (int Length, const RunOptions &Options, CheckpointData &Resumed, LengthResults &Results)
+{
+/* Examine All Chains of One Length, Sort Out the Self-Avoiding Polygons */
+	TimePoint StartTime, FinishTime;
+	double StartToFinish;
+
+/* Settings Changed or Looked Up Often */
+	int NumberOfThreads = Options.NumberOfThreads;
+	int PrefixBits = Options.PrefixBits;
+	const _TCHAR *ResumeFile = Options.ResumeFile;
+	PolygonStorage Storage = Options.Storage;
+	EnumerationEngine Engine = Options.Engine;
+
+/* Transfer Matrix:  Closed Chains Counted Without Enumeration (no open chains, no polygon codes) */
+	if (Engine == EngineTransferMatrix)
+	{
+		cout << "Counting polygons of length " << Length << " by transfer matrix ... ";
+		if (NumberOfThreads > 1)  cout << "(" << NumberOfThreads << " threads) ";
+		StartTime = Now();
+
+		uint64 ClosedChains, States, PeakBytes;
+		bool IsWithinLimit = CountPolygonsByTransferMatrix(Length, NumberOfThreads, Options.TransferMemory << 20, ClosedChains, States, PeakBytes);
+
+		StartToFinish = Duration(StartTime, Now());
+
+		if (!IsWithinLimit)
+		{
+			cerr << "\nERROR:  Transfer matrix needs more than " << Options.TransferMemory << " MB (--transfer-memory)\n";
+			exit(1);
+		}
+
+		cout << " done! \n\n";
+		cout << "(Largest table: " << States << " boundary states, peak footprint " << PeakBytes / 1048576.0
+			 << " MB, in " << StartToFinish << " seconds) \n\n";
+
+		Results = LengthResults();
+		Results.Length = Length;
+		Results.HasChains = false;
+		Results.HasPolygons = false;
+		Results.ClosedChains = ClosedChains;
+		Results.EnumerationSeconds = StartToFinish;
+		Results.FromTable = false;
+		Results.HasStatistics = false;
+		return;
+	}
+
+/* Storage for Self-Avoiding Polygon Chains */
+	CodeArena *Polygon = NULL;
+
+/* Hash Set Mode:  Unique Primitive Polygons Only */
+	PolygonHashSet *UniqueSet = NULL;
+
+/* Streaming Mode:  Run Buffers Instead (total size is fixed) */
+	RunBuffer *Buffers = NULL;
+	PolygonRuns *Runs = NULL;
+
+	if (Storage == StoreInRuns)
+	{
+		Runs = new PolygonRuns(Options.StreamPrefix);
+		if (Resumed.RunCount > 0)  Runs->Count = Resumed.RunCount;
+
+		size_t BufferCapacity = (size_t)((Options.RunBufferSize << 20) / sizeof(uint64) / NumberOfThreads);
+		if (BufferCapacity < 1024)  BufferCapacity = 1024;
+
+		Buffers = new RunBuffer [NumberOfThreads];
+
+		for (int t = 0; t < NumberOfThreads; ++t)
+		{
+			Buffers[t].Codes = new uint64 [BufferCapacity];
+			Buffers[t].Count = 0;
+			Buffers[t].Capacity = BufferCapacity;
+		}
+	}
+	else if (Storage == StoreInHashSet)
+	{
+		UniqueSet = new PolygonHashSet;
+	}
+	else
+	{
+		Polygon = new CodeArena;
+	}
+
+/* There are 2^(l-2) Different Chains (code space covers the leading turns of longer chains) */
+	uint64 MaxCode = ((uint64)1 << CodeBits(Length));
+
+	uint64 NonOverlaps = 0;
+	uint64 ClosedChains = 0;
+	uint64 ChainChecks = 0;
+
+/* Code Ranges Still to Be Examined */
+	std::vector<CodeRange> Pending;
+
+	if (ResumeFile != NULL)
+	{
+	/* Restore Polygons, Unfinished Ranges */
+		for (size_t i = 0; i < Resumed.PolygonCodes.size(); ++i)
+		{
+			if (Storage == StoreInHashSet)
+				UniqueSet->Insert(Resumed.PolygonCodes[i]);
+			else
+				Polygon->Append(Resumed.PolygonCodes[i]);
+		}
+
+	/* Codes Are Now Kept in Polygon Storage */
+		std::vector<uint64>().swap(Resumed.PolygonCodes);
+
+		Pending = Resumed.Ranges;
+	}
+	else if ((Options.FrontierPrefix != NULL) && (Engine != EngineHalfChainJoin) && (Length <= MaxCodeLength)
+			 && (Length - Options.FrontierDepth >= MinFrontierLength))
+	{
+	/* Code Ranges Behind Live Prefixes Only */
+		int Prefix = std::min(Length - Options.FrontierDepth, MaxFrontierLength);
+
+		std::vector<uint64> Live;
+		bool IsCached = LoadFrontier(Options.FrontierPrefix, Prefix, Live);
+		uint64 LivePrefixes = SeedFromFrontier(Live, Prefix, Length, Pending);
+
+		cout << "(Frontier of " << Prefix << " segments " << (IsCached ? "from cache" : "collected") << ": "
+			 << LivePrefixes << " of " << ((uint64)1 << CodeBits(Prefix)) << " prefixes alive) \n\n";
+	}
+	else
+	{
+	/* Complete Code Space */
+		CodeRange Range = {0, MaxCode};
+		Pending.push_back(Range);
+	}
+
+/* Split Code Space Into 2^K Prefix Ranges
+   (default: about 64 ranges per thread, to balance the uneven effect of pruning) */
+	if (PrefixBits < 0)
+	{
+		PrefixBits = 0;
+		if (NumberOfThreads > 1)
+		{
+			while ((1 << PrefixBits) < 64 * NumberOfThreads)  ++PrefixBits;
+		}
+	}
+	if (PrefixBits > CodeBits(Length))  PrefixBits = CodeBits(Length);
+
+	uint64 RangeSize = (MaxCode >> PrefixBits);
+
+/* Cut Pending Ranges at Prefix Boundaries */
+	std::vector<CodeRange> Ranges;
+	uint64 CodesPending = 0;
+
+	for (size_t i = 0; i < Pending.size(); ++i)
+	{
+		uint64 FirstCode = Pending[i].FirstCode;
+
+		while (FirstCode < Pending[i].EndCode)
+		{
+			CodeRange Range;
+			Range.FirstCode = FirstCode;
+			Range.EndCode = (FirstCode / RangeSize + 1) * RangeSize;
+			if (Range.EndCode > Pending[i].EndCode)  Range.EndCode = Pending[i].EndCode;
+
+			Ranges.push_back(Range);
+			CodesPending += Range.EndCode - Range.FirstCode;
+			FirstCode = Range.EndCode;
+		}
+	}
+
+	uint64 NumberOfRanges = Ranges.size();
+
+/* Counters for Each Thread (first thread carries on the counts of a resumed run) */
+	EnumerationTally *Tally = new EnumerationTally [NumberOfThreads];
+
+	for (int t = 0; t < NumberOfThreads; ++t)
+	{
+		Tally[t].NonOverlaps = 0;
+		Tally[t].ClosedChains = 0;
+		Tally[t].ChainChecks = 0;
+	}
+
+	if (ResumeFile != NULL)  Tally[0] = Resumed.Totals;
+
+/* Set Up Shared Job Description */
+	EnumerationJob Job;
+	Job.Length = Length;
+	Job.MaxCode = MaxCode;
+	Job.NumberOfThreads = NumberOfThreads;
+	Job.Engine = Engine;
+	Job.Overlap = Options.Overlap;
+	Job.Specialized = Options.Specialized;
+	Job.TailBits = (Length >= 16) ? Options.TailBits : 0;
+	Job.Reversal = Options.Reversal;
+	Job.Counters.Clear();
+	Job.Polygon = Polygon;
+	Job.Storage = Storage;
+	Job.UniqueSet = UniqueSet;
+	Job.Buffers = Buffers;
+	Job.Runs = Runs;
+	Job.Tally = Tally;
+	Job.CodesDone = MaxCode - CodesPending;
+	Job.Queues = new WorkQueue [NumberOfThreads];
+	Job.Checkpoint = NULL;
+	Job.Statistics = Options.ChainStatistics ? new StatisticsAccumulator [NumberOfThreads] : NULL;
+
+	if (Options.CheckpointFile != NULL)
+	{
+		Job.Checkpoint = new CheckpointControl(Options.CheckpointFile, Options.CheckpointInterval, NumberOfThreads);
+	}
+
+/* Distribute Ranges in Contiguous Blocks Among Threads */
+	for (uint64 i = 0; i < NumberOfRanges; ++i)
+	{
+		Job.Queues[(i * NumberOfThreads) / NumberOfRanges].Ranges.push_back(Ranges[(size_t)i]);
+	}
+
+/* EXAMINE ALL CHAINS FOR OVERLAPS */
+
+/* Timing Support - Start of Calculation */
+	cout << "Calculating chains of length " << Length << " ... ";
+	if (NumberOfThreads > 1)  cout << "(" << NumberOfThreads << " threads, " << NumberOfRanges << " ranges) ";
+	StartTime = Now();
+
+/* Loop Through Chains, Search for Overlaps and Closed Self-Avoiding Chains */
+	if (Engine == EngineHalfChainJoin)
+	{
+	/* Polygons Only:  Join Pairs of Half-Chains */
+		JoinHalfChains(Job);
+	}
+	else if (NumberOfThreads == 1)
+	{
+	/* Single Thread:  Work Directly */
+		EnumerationWorker(0, &Job, &Tally[0]);
+	}
+	else
+	{
+	/* Start Worker Threads, Wait For Them to Finish */
+		std::vector<std::thread> Workers;
+
+		for (int t = 0; t < NumberOfThreads; ++t)
+		{
+			Workers.push_back(std::thread(EnumerationWorker, t, &Job, &Tally[t]));
+		}
+
+		for (int t = 0; t < NumberOfThreads; ++t)
+		{
+			Workers[t].join();
+		}
+	}
+
+/* Merge Results of All Threads */
+	for (int t = 0; t < NumberOfThreads; ++t)
+	{
+		NonOverlaps += Tally[t].NonOverlaps;
+		ClosedChains += Tally[t].ClosedChains;
+		ChainChecks += Tally[t].ChainChecks;
+	}
+
+	delete[] Tally;
+	delete[] Job.Queues;
+	delete Job.Checkpoint;
+
+/* Merge Statistics of All Threads */
+	Results.HasStatistics = (Job.Statistics != NULL);
+	Results.Statistics.Clear();
+
+	if (Job.Statistics != NULL)
+	{
+		for (int t = 0; t < NumberOfThreads; ++t)  Results.Statistics += Job.Statistics[t].Totals;
+		delete[] Job.Statistics;
+	}
+
+/* Timing Support - End of Calculation */
+	FinishTime = Now();
+	StartToFinish = Duration(StartTime, FinishTime);
+
+	Results.EnumerationSeconds = StartToFinish;
+	COUNT(PrintCounterTotals(Job.Counters, StartToFinish));
+
+/* Send a Brief Message */
+	cout << " done! \n\n";
+	cout << "(Evaluations performed: " << ChainChecks << " out of " << MaxCode << " in " << StartToFinish << " seconds) \n\n";
+
+	if (Polygon != NULL)
+	{
+		cout << "(Polygon storage: " << Polygon->Count << " codes, peak footprint "
+			 << Polygon->PeakBytes / 1048576.0 << " MB) \n\n";
+	}
+
+	if (UniqueSet != NULL)
+	{
+		cout << "(Polygon hash set: " << UniqueSet->Count() << " unique primitives in "
+			 << UniqueSet->Bytes() / 1048576.0 << " MB) \n\n";
+	}
+
+/* SORT OUT SELF-AVOIDING POLYGONS */
+
+/* Timing Support - Start of Calculation */
+	cout << "Now Examining " << ClosedChains << " Self-Avoiding Polygons ... \n\n";
+	StartTime = Now();
+
+	SymmetryCensus Census;
+	uint64 UniquePolygons;
+
+/* Hash Set and Streaming Modes:  Primitives Reduced and Sorted During Enumeration */
+	AnalysisTimes Phases = {0, 0, 0};
+
+/* Catalog of Unique Polygons (only for codes of 64 bits) */
+	CatalogWriter *Catalog = NULL;
+	std::basic_string<_TCHAR> CatalogFile;
+
+	if ((Options.CatalogPrefix != NULL) && (Length <= MaxCodeLength))
+	{
+		std::basic_ostringstream<_TCHAR> Name;
+		Name << Options.CatalogPrefix << _T(".catalog") << std::setw(2) << std::setfill(_T('0')) << Length;
+		CatalogFile = Name.str();
+
+		Catalog = new CatalogWriter;
+
+		if (!Catalog->Open(CatalogFile.c_str(), Length, Options.CatalogSymmetry))
+		{
+			cerr << "WARNING:  Could not write polygon catalog\n";
+			delete Catalog;
+			Catalog = NULL;
+		}
+	}
+
+	if (Storage == StoreInHashSet)
+	{
+	/* Hash Set Mode:  Duplicates Are Gone Already, No Sort Necessary */
+		UniquePolygons = CensusOfHashSet(*UniqueSet, Length, Census, Catalog);
+		delete UniqueSet;
+	}
+	else if (Storage == StoreInRuns)
+	{
+	/* Streaming Mode:  Write Remaining Codes to Disk, Then Merge Runs */
+		for (int t = 0; t < NumberOfThreads; ++t)
+		{
+			FlushRunBuffer(Buffers[t], *Runs);
+			delete[] Buffers[t].Codes;
+		}
+		delete[] Buffers;
+
+		UniquePolygons = MergePolygonRuns(*Runs, Length, Census, Catalog);
+		delete Runs;
+	}
+	else
+	{
+		if (Options.InPlaceSort)
+			UniquePolygons = SortOutPolygonsInPlace(*Polygon, Length, NumberOfThreads, Census, Phases, Catalog);
+		else
+			UniquePolygons = SortOutPolygons(*Polygon, Length, NumberOfThreads, Census, Phases, Catalog);
+		delete Polygon;
+	}
+
+/* Timing Support - End of Calculation */
+	FinishTime = Now();
+	StartToFinish = Duration(StartTime, FinishTime);
+
+	Results.AnalysisSeconds = StartToFinish;
+	if (Storage != StoreInMemory)  Phases.Census = StartToFinish;
+	Results.Phases = Phases;
+
+/* Send a Brief Message */
+	cout << "(Found " << UniquePolygons << " unique self-avoiding polygon(s) in " << StartToFinish << " seconds) \n\n";
+
+	if (Catalog != NULL)
+	{
+		if (Catalog->Close(Census))
+			cout << "(Catalog of " << Catalog->Count() << " polygons written to " << CatalogFile << ") \n\n";
+		else
+			cerr << "WARNING:  Could not write polygon catalog\n";
+
+		delete Catalog;
+	}
+
+/* Collect Results */
+	Results.Length = Length;
+	Results.HasChains = (Engine != EngineHalfChainJoin);
+	Results.HasPolygons = (Length <= MaxCodeLength);
+	Results.NonOverlaps = NonOverlaps;
+	Results.ClosedChains = ClosedChains;
+	Results.UniquePolygons = UniquePolygons;
+	Results.Census = Census;
+	Results.ChainChecks = ChainChecks;
+	Results.CodeSpace = MaxCode;
+	Results.FromTable = false;
+}
+
+/* *** BENCHMARK SUITE *** */
+
+/* The benchmark runs every engine over a range of chain lengths with the same settings (threads, polygon
+   storage, tail batches), and no results table, frontier cache or checkpoint to shorten the work.  For each
+   run it reports the chains covered per second, the fraction of the code space pruned by smart jumps, the
+   time of each phase, and the peak memory of the process so far.  All counts are checked against the table of
+   known results (Bracher, May 4, 2014, in "2DChain Known Results.h", shared with the CUDA version), so that no
+   change to the code can go unnoticed that changes an answer.  A mismatch makes the program return a failure
+   status. */
+
+/* Outcome of the Check Against Known Results */
+enum ReferenceCheck
+{
+	CheckPassed = 0,	/* all counts determined agree */
+	CheckFailed = 1,	/* some count differs */
+	CheckUnknown = 2	/* no known results for this length */
+};
+
+ReferenceCheck CheckAgainstReference (const LengthResults &Results)
+{
+/* Compare Counts Determined in a Run With the Known Results (counts not determined are left out) */
+	for (int i = 0; i < KnownLengths; ++i)
+	{
+		const ReferenceCounts &Known = KnownResults[i];
+		if (Known.Length != Results.Length)  continue;
+
+		if (Results.HasChains && (Results.NonOverlaps != Known.NonOverlaps))  return CheckFailed;
+		if (Results.ClosedChains != Known.ClosedChains)  return CheckFailed;
+
+		if (Results.HasPolygons)
+		{
+			const SymmetryCensus &Census = Results.Census;
+			uint64 Classes[8] = {Census.SC1, Census.SC1m, Census.SC2, Census.SC2m, Census.SC3, Census.SC3m, Census.SC6, Census.SC6m};
+
+			if (Results.UniquePolygons != Known.UniquePolygons)  return CheckFailed;
+			for (int k = 0; k < 8; ++k)
+			{
+				if (Classes[k] != Known.Classes[k])  return CheckFailed;
+			}
+		}
+
+		return CheckPassed;
+	}
+
+	return CheckUnknown;
+}
+
+double PeakMemory ()
+{
+/* Peak Memory of the Process So Far (resident set, in MB) */
+#if defined (_WIN32)
+	PROCESS_MEMORY_COUNTERS Counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)))  return 0;
+
+	return Counters.PeakWorkingSetSize / 1048576.0;
+#else
+	struct rusage Usage;
+	if (getrusage(RUSAGE_SELF, &Usage) != 0)  return 0;
+
+#if defined (__APPLE__)
+	return Usage.ru_maxrss / 1048576.0;
+#else
+	return Usage.ru_maxrss / 1024.0;
+#endif
+#endif
+}
+
+struct BenchmarkCase
+{
+/* Engine Settings of One Benchmark Case */
+	const char *Name;
+	EnumerationEngine Engine;
+	OverlapEngine Overlap;
+	bool Reversal;
+};
+
+const BenchmarkCase BenchmarkCases[] =
+{
+	{"code-distance", EngineByCode, OverlapByDistance, false},
+	{"code-bitmap", EngineByCode, OverlapByBitmap, false},
+	{"code-packed", EngineByCode, OverlapByPackedSites, false},
+#if defined (HAS_SSE2)
+	{"code-simd", EngineByCode, OverlapByPackedSimd, false},
+#endif
+	{"code-reversal", EngineByCode, OverlapByPackedSites, true},
+	{"dfs", EngineDepthFirst, OverlapByPackedSites, false},
+	{"join", EngineHalfChainJoin, OverlapByPackedSites, false},
+	{"transfer", EngineTransferMatrix, OverlapByPackedSites, false}
+};
+
+const int NumberOfCases = sizeof(BenchmarkCases) / sizeof(BenchmarkCase);
+
+struct BenchmarkRecord
+{
+/* Results, Peak Memory and Outcome of the Check for One Case and Length */
+	const char *Case;
+	LengthResults Results;
+	int Threads;
+	double PeakMB;
+	ReferenceCheck Check;
+};
+
+void WriteBenchmarkFile (const _TCHAR *FileName, bool AsCSV, const std::vector<BenchmarkRecord> &Records)
+{
+/* Machine-Readable Benchmark Results (JSON array of records, or CSV with header line) */
+
+	FILE *File = _tfopen(FileName, _T("w"));
+	if (File == NULL)
+	{
+		cerr << "WARNING:  Could not write benchmark file\n";
+		return;
+	}
+
+	const char *Empty = AsCSV ? "" : "null";
+	const char *Names[17] = {"Case", "Length", "Check", "NonOverlaps", "ClosedChains", "UniquePolygons",
+							 "ChainChecks", "CodeSpace", "PrunedFraction", "ChainsPerSecond",
+							 "EnumerationSeconds", "ReduceSeconds", "SortSeconds", "CensusSeconds",
+							 "AnalysisSeconds", "PeakMB", "Threads"};
+	const char *Checks[3] = {"passed", "FAILED", "unknown"};
+
+	if (AsCSV)
+	{
+		for (int k = 0; k < 17; ++k)  fprintf(File, (k == 0) ? "%s" : ",%s", Names[k]);
+		fprintf(File, "\n");
+	}
+	else
+	{
+		fprintf(File, "[\n");
+	}
+
+	for (size_t i = 0; i < Records.size(); ++i)
+	{
+		const LengthResults &Results = Records[i].Results;
+		double Seconds = (Results.EnumerationSeconds > 0) ? Results.EnumerationSeconds : 1e-9;
+
+	/* Fields as Text, in the Order of Names */
+		char Field[17][32];
+
+		sprintf(Field[0], AsCSV ? "%s" : "\"%s\"", Records[i].Case);
+		sprintf(Field[1], "%d", Results.Length);
+		sprintf(Field[2], AsCSV ? "%s" : "\"%s\"", Checks[Records[i].Check]);
+		sprintf(Field[3], "%llu", (unsigned long long)Results.NonOverlaps);
+		sprintf(Field[4], "%llu", (unsigned long long)Results.ClosedChains);
+		sprintf(Field[5], "%llu", (unsigned long long)Results.UniquePolygons);
+		sprintf(Field[6], "%llu", (unsigned long long)Results.ChainChecks);
+		sprintf(Field[7], "%llu", (unsigned long long)Results.CodeSpace);
+		sprintf(Field[8], "%.6f", 1.0 - (double)Results.ChainChecks / Results.CodeSpace);
+		sprintf(Field[9], "%.0f", Results.CodeSpace / Seconds);
+		sprintf(Field[10], "%.3f", Results.EnumerationSeconds);
+		sprintf(Field[11], "%.3f", Results.Phases.Reduce);
+		sprintf(Field[12], "%.3f", Results.Phases.Sort);
+		sprintf(Field[13], "%.3f", Results.Phases.Census);
+		sprintf(Field[14], "%.3f", Results.AnalysisSeconds);
+		sprintf(Field[15], "%.1f", Records[i].PeakMB);
+		sprintf(Field[16], "%d", Records[i].Threads);
+
+		if (!Results.HasChains)
+		{
+			strcpy(Field[3], Empty);
+			strcpy(Field[6], Empty);
+			strcpy(Field[8], Empty);
+		}
+		if (!Results.HasPolygons)  strcpy(Field[5], Empty);
+
+		if (AsCSV)
+		{
+			for (int k = 0; k < 17; ++k)  fprintf(File, (k == 0) ? "%s" : ",%s", Field[k]);
+			fprintf(File, "\n");
+		}
+		else
+		{
+			fprintf(File, "  {");
+			for (int k = 0; k < 17; ++k)  fprintf(File, "%s\"%s\": %s", (k == 0) ? "" : ", ", Names[k], Field[k]);
+			fprintf(File, (i + 1 < Records.size()) ? "},\n" : "}\n");
+		}
+	}
+
+	if (!AsCSV)  fprintf(File, "]\n");
+
+	if ((ferror(File) != 0) | (fclose(File) != 0))  cerr << "WARNING:  Could not write benchmark file\n";
+}
+
+int RunBenchmark (int FirstLength, int LastLength, const RunOptions &Settings, const _TCHAR *OutputFile, bool AsCSV)
+{
+/* Run All Benchmark Cases Over a Range of Chain Lengths, Check the Counts, Summarize
+   Function Value Returned is the Exit Status (1: some count differs from the known results) */
+	std::vector<BenchmarkRecord> Records;
 
-/* Specify Polygons By Symmetry Class: */
-	cout << "Self-Avoiding Polygon(s) By Symmetry Class: \n\n";
+/* Shortest Chains (2, 3 segments) Are Always Checked First:  Fixed Head Only, or a Single Free Turn */
+	std::vector<int> Lengths;
+	for (int Length = 2; Length <= 3; ++Length)
+	{
+		if (Length < FirstLength)  Lengths.push_back(Length);
+	}
+	for (int Length = FirstLength; Length <= LastLength; ++Length)  Lengths.push_back(Length);
 
-	cout << "Class 1  (trivial symmetry group) ............ " << SC1 << "\n"
-		 << "Class 1m (only mirror symmetry) .............. " << SC1m << "\n"
-		 << "Class 2  (symmetry under 180 rotations) ..... " << SC2 << "\n"
-		 << "Class 2m (180 rotation & mirror symmetry) ... " << SC2m << "\n"
-		 << "Class 3  (symmetry under 120 rotations) ..... " << SC3 << "\n"
-		 << "Class 3m (120 rotation & mirror symmetry) ... " << SC3m << "\n"
-		 << "Class 6  (symmetry under 60 rotations) ...... " << SC6 << "\n"
-		 << "Class 6m (60 rotation & mirror symmetry) .... " << SC6m << "\n\n";
+	for (size_t l = 0; l < Lengths.size(); ++l)
+	{
+		int Length = Lengths[l];
 
-/* Clean-Up Memory */
-	delete[] ChainArray;
-	delete[] PrimitivePolygon;
+		for (int c = 0; c < NumberOfCases; ++c)
+		{
+			const BenchmarkCase &Case = BenchmarkCases[c];
+
+		/* Lengths Beyond the Reach of an Engine */
+			if ((Case.Engine == EngineByCode) && (Length > MaxCodeLength))  continue;
+			if ((Case.Engine == EngineHalfChainJoin) && (Length < 6))  continue;
+
+			RunOptions Options = Settings;
+			Options.CatalogPrefix = NULL;
+			Options.ChainStatistics = false;
+			Options.Engine = Case.Engine;
+			Options.Overlap = Case.Overlap;
+			Options.Reversal = Case.Reversal;
+
+			CheckpointData Resumed;
+			Resumed.Storage = Options.Storage;
+			Resumed.RunCount = 0;
+
+			cout << "\n *** BENCHMARK " << Case.Name << ", chains of length " << Length << ":\n\n";
+
+			BenchmarkRecord Record;
+			Record.Case = Case.Name;
+			Record.Threads = Options.NumberOfThreads;
+			EnumerateLength(Length, Options, Resumed, Record.Results);
+			Record.PeakMB = PeakMemory();
+			Record.Check = CheckAgainstReference(Record.Results);
+
+			Records.push_back(Record);
+			if (OutputFile != NULL)  WriteBenchmarkFile(OutputFile, AsCSV, Records);
+		}
+	}
+
+/* Summary Table */
+	const char *Checks[3] = {"passed", "FAILED", "unknown"};
+	bool IsFailed = false;
+
+	cout << "\n *** BENCHMARK SUMMARY (" << Settings.NumberOfThreads << " thread(s), times in seconds):\n\n"
+		 << " Case            Length  M chains/s  pruned   enumerate    reduce      sort    census   peak MB  check\n";
+
+	for (size_t i = 0; i < Records.size(); ++i)
+	{
+		const LengthResults &Results = Records[i].Results;
+		double Seconds = (Results.EnumerationSeconds > 0) ? Results.EnumerationSeconds : 1e-9;
+
+		char Line[160];
+		sprintf(Line, " %-15s %6d %11.2f %7.4f %11.3f %9.3f %9.3f %9.3f %9.1f  %s\n", Records[i].Case, Results.Length,
+				Results.CodeSpace / Seconds / 1e6, Results.HasChains ? 1.0 - (double)Results.ChainChecks / Results.CodeSpace : 0.0,
+				Results.EnumerationSeconds, Results.Phases.Reduce, Results.Phases.Sort, Results.Phases.Census,
+				Records[i].PeakMB, Checks[Records[i].Check]);
+		cout << Line;
+
+		if (Records[i].Check == CheckFailed)  IsFailed = true;
+	}
+
+	cout << "\n" << (IsFailed ? "ERROR:  Counts differ from the known results\n" : "All counts agree with the known results (as far as known)\n");
+
+	return IsFailed ? 1 : 0;
+}
+
+/* *** LIBRARY INTERFACE *** */
+
+/* The functions declared in "2DChain Library.h", for programs that link the enumerator directly (build with
+   BUILD_LIBRARY defined, which leaves out the main program).  Chains are found by the same depth-first search
+   as the dfs engine, one at a time on the calling thread; each one is handed to the caller right away and
+   nothing is kept, so that the caller may filter chains, or stop at any time.  Polygons are only rebuilt,
+   reduced or classified when asked for, on arrays of codes supplied by the caller. */
+
+bool EnumerateChainRange (int Length, ChainCode FirstCode, ChainCode EndCode, const ChainCallback &Callback,
+						  ChainSelection Selection)
+{
+/* Search All Chains With Codes FirstCode ... EndCode - 1, Pass On the Chains Selected in Ascending Order of Their Codes
+   Function Value Returned is true If the Search Ran Until the End */
+	if ((Length < 3) || (Length > LibraryMaxLength))  return false;
+
+	uint64 MaxCode = (uint64)1 << (Length - 2);
+	if (EndCode > MaxCode)  EndCode = MaxCode;
+	if (FirstCode >= EndCode)  return true;
+
+/* Fixed Head of Chain (atoms 0, 1, 2) */
+	std::vector<LatticeVector> ChainArray(Length + 1);
+	OccupancyMap Map;
+
+	BuildChain(0, Length, ChainArray.data());
+	Map.Reset(Length, ChainArray.data());
+
+/* Search Stack:  Turn Leading to Atom k (0: left, 1: right), Orientation of Segment Leaving Atom k,
+   Code Bits of Turns Up to Atom k */
+	std::array<int, MaxChainLength + 1> Turn;
+	std::array<int, MaxChainLength + 1> Orientation;
+	std::array<uint64, MaxChainLength + 1> Prefix;
+
+	Turn.fill(0);
+	Orientation.fill(1);
+	Prefix.fill(0);
+
+/* Smallest Code Not Examined Yet, Start With Atom #3 */
+	uint64 Code = FirstCode;
+
+	int k = 3;
+	Turn[k] = (int)((Code >> (Length - k)) & 1);
+
+	while (k >= 3)
+	{
+	/* *** Task #1:  Place Atom k */
+		ChainArray[k] = ChainArray[k-1];
+
+		if (Turn[k] == 0)
+		{
+			ChainArray[k].LeftTurn(Orientation[k-1]);
+			Orientation[k] = Orientation[k-1] + 1;
+		}
+		else
+		{
+			ChainArray[k].RightTurn(Orientation[k-1]);
+			Orientation[k] = Orientation[k-1] - 1;
+		}
+
+		Prefix[k] = (Prefix[k-1] << 1) | Turn[k];
+
+	/* *** Task #2:  Check for Overlap, Pass On Complete Chains, Go Deeper If Possible */
+		bool IsFinished = true;
+		bool IsWanted = true;
+
+		if (Map.IsOccupied(ChainArray[k]))
+		{
+		/* Closed Non-Overlapping Chain?  (only the first atom can be in the way) */
+			if ((k == Length) && (ChainArray[Length] == ChainArray[0]) && ((Selection & SelectClosedChains) != 0))
+				IsWanted = Callback(Prefix[Length], true);
+		}
+		else if (k == Length)
+		{
+			if ((Selection & SelectOpenChains) != 0)  IsWanted = Callback(Prefix[Length], false);
+		}
+		else
+		{
+		/* Occupy Site, Continue With Next Atom */
+			Map.Set(ChainArray[k]);
+			++k;
+
+			Turn[k] = (int)((Code >> (Length - k)) & 1);
+			IsFinished = false;
+		}
+
+		if (!IsWanted)  return false;
+
+	/* *** Task #3:  Node Finished - Step to Next Turn ("smart jump"), Back Up Past Right Turns */
+		while (IsFinished)
+		{
+			Code = (Prefix[k] + 1) << (Length - k);
+			if (Code >= EndCode)  return true;
+
+			if (Turn[k] == 0)
+			{
+			/* Try Right Turn Next */
+				Turn[k] = 1;
+				IsFinished = false;
+			}
+			else
+			{
+			/* Both Turns Done:  Back Up, Free Site of Previous Atom */
+				--k;
+				if (k < 3)  break;
+
+				Map.Clear(ChainArray[k]);
+			}
+		}
+	}
+
+	return true;
+}
+
+bool EnumerateChains (int Length, const ChainCallback &Callback, ChainSelection Selection)
+{
+/* Search All Chains of a Length */
+	return EnumerateChainRange(Length, 0, ~(ChainCode)0, Callback, Selection);
+}
+
+ChainCode PolygonCode (ChainCode Chain, int Length)
+{
+/* Complete Polygon Code of a Closed Chain */
+	return PolyMath(Chain, Length).Code;
+}
+
+void CanonicalizePolygons (const ChainCode *Polygons, size_t Count, int Length, ChainCode *Primitives)
+{
+/* Reduce Polygon Codes to Primitive Codes */
+	PolyMath Primitive;
+	Primitive.Length = Length;
+
+	for (size_t i = 0; i < Count; ++i)
+	{
+		Primitive.Code = Polygons[i];
+		Primitive.Reduce();
+		Primitives[i] = Primitive.Code;
+	}
+}
+
+void ClassifyPolygons (const ChainCode *Polygons, size_t Count, int Length, unsigned char *Classes)
+{
+/* Symmetry Classes of Polygons (census of the classes is not kept) */
+	SymmetryCensus Census;
+	PolyMath Polygon;
+	Polygon.Length = Length;
+
+	for (size_t i = 0; i < Count; ++i)
+	{
+		Polygon.Code = Polygons[i];
+		Classes[i] = (unsigned char)Census.Add(Polygon);
+	}
+}
+
+void PolygonSites (ChainCode Polygon, int Length, int *Sites)
+{
+/* Rebuild Polygon (the final turn is implied by closure), Copy Grid Coordinates of Its Atoms */
+	std::vector<LatticeVector> ChainArray(Length + 1);
+	BuildChain(Polygon >> 1, Length, ChainArray.data());
+
+	for (int k = 0; k <= Length; ++k)
+	{
+		Sites[3 * k] = ChainArray[k].n1;
+		Sites[3 * k + 1] = ChainArray[k].n2;
+		Sites[3 * k + 2] = ChainArray[k].n3;
+	}
+}
+
+#if !defined (BUILD_LIBRARY)
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+	int Length = 0;
+
+/* Command Line Options:  Number of Threads, Number of Prefix Bits Used to Split the Code Space,
+   Checkpoint File and Interval (in seconds), Checkpoint File to Resume From,
+   Prefix of Run Files for Streaming Mode, Total Size of Run Buffers (in MB), Hash Set Mode,
+   Method of Enumeration, Method of Overlap Check (code engine only), Generic Engine for All Lengths,
+   Batches of Tails, Reduced Enumeration, Sweep Over Chain Lengths (0: single length from input),
+   Results Table, Frontier Cache and Depth, Chain Length (0: from input), File and Format of Machine-Readable Results,
+   Benchmark Over Chain Lengths (0: none), Catalogs of Polygons and Their Symmetry Bytes, Catalog to Check,
+   Statistics of Open Chains, Analysis Within Polygon Storage, Memory Limit of the Transfer Matrix (in MB) */
+	int NumberOfThreads = 1;
+	int PrefixBits = -1;
+	const _TCHAR *CheckpointFile = NULL;
+	time_t CheckpointInterval = 900;
+	const _TCHAR *ResumeFile = NULL;
+	const _TCHAR *StreamPrefix = NULL;
+	uint64 RunBufferSize = 256;
+	bool UseHashSet = false;
+	OverlapEngine Overlap = OverlapByPackedSites;
+	EnumerationEngine Engine = EngineByCode;
+	bool Specialized = true;
+	int TailBits = MaxTailBits;
+	bool Reversal = false;
+	int SweepFirst = 0, SweepLast = 0;
+	const _TCHAR *ResultsFile = NULL;
+	const _TCHAR *FrontierPrefix = NULL;
+	int FrontierDepth = 12;
+	const _TCHAR *OutputFile = NULL;
+	int OutputFormat = -1;
+	int BenchmarkFirst = 0, BenchmarkLast = 0;
+	const _TCHAR *CatalogPrefix = NULL;
+	bool CatalogSymmetry = false;
+	const _TCHAR *CatalogToCheck = NULL;
+	bool ChainStatistics = false;
+	bool InPlaceSort = false;
+	uint64 TransferMemory = 4096;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if ((_tcscmp(argv[i], _T("--threads")) == 0) && (i + 1 < argc))
+		{
+			NumberOfThreads = _ttoi(argv[++i]);
+		}
+		else if ((_tcscmp(argv[i], _T("--prefix-bits")) == 0) && (i + 1 < argc))
+		{
+			PrefixBits = _ttoi(argv[++i]);
+		}
+		else if ((_tcscmp(argv[i], _T("--checkpoint")) == 0) && (i + 1 < argc))
+		{
+			CheckpointFile = argv[++i];
+		}
+		else if ((_tcscmp(argv[i], _T("--checkpoint-interval")) == 0) && (i + 1 < argc))
+		{
+			CheckpointInterval = (time_t)_ttoi(argv[++i]);
+		}
+		else if ((_tcscmp(argv[i], _T("--resume")) == 0) && (i + 1 < argc))
+		{
+			ResumeFile = argv[++i];
+		}
+		else if ((_tcscmp(argv[i], _T("--stream")) == 0) && (i + 1 < argc))
+		{
+			StreamPrefix = argv[++i];
+		}
+		else if ((_tcscmp(argv[i], _T("--run-buffer")) == 0) && (i + 1 < argc))
+		{
+			RunBufferSize = (uint64)_ttoi(argv[++i]);
+		}
+		else if (_tcscmp(argv[i], _T("--hash")) == 0)
+		{
+			UseHashSet = true;
+		}
+		else if ((_tcscmp(argv[i], _T("--engine")) == 0) && (i + 1 < argc) && (_tcscmp(argv[i + 1], _T("code")) == 0))
+		{
+			Engine = EngineByCode;
+			++i;
+		}
+		else if ((_tcscmp(argv[i], _T("--engine")) == 0) && (i + 1 < argc) && (_tcscmp(argv[i + 1], _T("dfs")) == 0))
+		{
+			Engine = EngineDepthFirst;
+			++i;
+		}
+		else if ((_tcscmp(argv[i], _T("--engine")) == 0) && (i + 1 < argc) && (_tcscmp(argv[i + 1], _T("join")) == 0))
+		{
+			Engine = EngineHalfChainJoin;
+			++i;
+		}
+		else if ((_tcscmp(argv[i], _T("--engine")) == 0) && (i + 1 < argc) && (_tcscmp(argv[i + 1], _T("transfer")) == 0))
+		{
+			Engine = EngineTransferMatrix;
+			++i;
+		}
+		else if ((_tcscmp(argv[i], _T("--transfer-memory")) == 0) && (i + 1 < argc))
+		{
+			TransferMemory = (uint64)_ttoi(argv[++i]);
+		}
+		else if ((_tcscmp(argv[i], _T("--overlap")) == 0) && (i + 1 < argc) && (_tcscmp(argv[i + 1], _T("distance")) == 0))
+		{
+			Overlap = OverlapByDistance;
+			++i;
+		}
+		else if ((_tcscmp(argv[i], _T("--overlap")) == 0) && (i + 1 < argc) && (_tcscmp(argv[i + 1], _T("bitmap")) == 0))
+		{
+			Overlap = OverlapByBitmap;
+			++i;
+		}
+		else if ((_tcscmp(argv[i], _T("--overlap")) == 0) && (i + 1 < argc) && (_tcscmp(argv[i + 1], _T("packed")) == 0))
+		{
+			Overlap = OverlapByPackedSites;
+			++i;
+		}
+		else if ((_tcscmp(argv[i], _T("--overlap")) == 0) && (i + 1 < argc) && (_tcscmp(argv[i + 1], _T("simd")) == 0))
+		{
+		/* SIMD Distance Check Where Available, Scalar Packed Check Otherwise */
+#if defined (HAS_SSE2)
+			Overlap = OverlapByPackedSimd;
+#else
+			Overlap = OverlapByPackedSites;
+#endif
+			++i;
+		}
+		else if (_tcscmp(argv[i], _T("--generic")) == 0)
+		{
+			Specialized = false;
+		}
+		else if (_tcscmp(argv[i], _T("--reversal")) == 0)
+		{
+			Reversal = true;
+		}
+		else if ((_tcscmp(argv[i], _T("--tail-batch")) == 0) && (i + 1 < argc))
+		{
+			TailBits = std::max(0, std::min(MaxTailBits, _ttoi(argv[++i])));
+		}
+		else if ((_tcscmp(argv[i], _T("--sweep")) == 0) && (i + 2 < argc) && (_ttoi(argv[i + 1]) >= 2) && (_ttoi(argv[i + 2]) >= _ttoi(argv[i + 1])))
+		{
+			SweepFirst = _ttoi(argv[++i]);
+			SweepLast = _ttoi(argv[++i]);
+		}
+		else if ((_tcscmp(argv[i], _T("--benchmark")) == 0) && (i + 2 < argc) && (_ttoi(argv[i + 1]) >= 2) && (_ttoi(argv[i + 2]) >= _ttoi(argv[i + 1])))
+		{
+			BenchmarkFirst = _ttoi(argv[++i]);
+			BenchmarkLast = _ttoi(argv[++i]);
+		}
+		else if ((_tcscmp(argv[i], _T("--catalog")) == 0) && (i + 1 < argc))
+		{
+			CatalogPrefix = argv[++i];
+		}
+		else if (_tcscmp(argv[i], _T("--catalog-symmetry")) == 0)
+		{
+			CatalogSymmetry = true;
+		}
+		else if (_tcscmp(argv[i], _T("--chain-statistics")) == 0)
+		{
+			ChainStatistics = true;
+		}
+		else if (_tcscmp(argv[i], _T("--in-place-sort")) == 0)
+		{
+			InPlaceSort = true;
+		}
+		else if ((_tcscmp(argv[i], _T("--check-catalog")) == 0) && (i + 1 < argc))
+		{
+			CatalogToCheck = argv[++i];
+		}
+		else if ((_tcscmp(argv[i], _T("--results")) == 0) && (i + 1 < argc))
+		{
+			ResultsFile = argv[++i];
+		}
+		else if ((_tcscmp(argv[i], _T("--frontier-cache")) == 0) && (i + 1 < argc))
+		{
+			FrontierPrefix = argv[++i];
+		}
+		else if ((_tcscmp(argv[i], _T("--frontier-depth")) == 0) && (i + 1 < argc))
+		{
+			FrontierDepth = std::max(1, _ttoi(argv[++i]));
+		}
+		else if ((_tcscmp(argv[i], _T("--length")) == 0) && (i + 1 < argc))
+		{
+			Length = _ttoi(argv[++i]);
+		}
+		else if ((_tcscmp(argv[i], _T("--output")) == 0) && (i + 1 < argc))
+		{
+			OutputFile = argv[++i];
+		}
+		else if ((_tcscmp(argv[i], _T("--format")) == 0) && (i + 1 < argc) && (_tcscmp(argv[i + 1], _T("json")) == 0))
+		{
+			OutputFormat = 0;
+			++i;
+		}
+		else if ((_tcscmp(argv[i], _T("--format")) == 0) && (i + 1 < argc) && (_tcscmp(argv[i + 1], _T("csv")) == 0))
+		{
+			OutputFormat = 1;
+			++i;
+		}
+		else
+		{
+			cerr << "Usage: 2DChain [--threads N (0: all cores)] [--prefix-bits K]\n"
+				 << "               [--checkpoint FILE] [--checkpoint-interval SECONDS] [--resume FILE]\n"
+				 << "               [--stream RUNFILE-PREFIX] [--run-buffer MB] [--hash]\n"
+				 << "               [--engine code|dfs|join|transfer] [--overlap bitmap|distance|packed|simd] [--generic]\n"
+				 << "               [--tail-batch BITS (0 ... 5, default 5, packed sites only)] [--reversal]\n"
+				 << "               [--sweep FIRST LAST] [--results FILE] [--frontier-cache PREFIX] [--frontier-depth K]\n"
+				 << "               [--length N] [--output FILE] [--format json|csv (default: from file name)]\n"
+				 << "               [--benchmark FIRST LAST (all engines, counts checked against known results)]\n"
+				 << "               [--catalog PREFIX] [--catalog-symmetry] [--check-catalog FILE] [--chain-statistics]\n"
+				 << "               [--in-place-sort] [--transfer-memory MB]\n";
+			return 1;
+		}
+	}
+
+/* Check a Catalog Written Before, Nothing Else */
+	if (CatalogToCheck != NULL)
+	{
+		CatalogReader Catalog;
+
+		if (!Catalog.Open(CatalogToCheck))
+		{
+			cerr << "ERROR:  Could not read polygon catalog (file missing, or layout damaged)\n";
+			return 1;
+		}
+
+		SymmetryCensus Census;
+		bool IsValid = VerifyCatalog(Catalog, Census);
+
+		cout << "Catalog of " << Catalog.Count() << " polygons with " << Catalog.Length() << " segments"
+			 << (Catalog.HasSymmetry() ? " (with symmetry classes)" : "") << ":  " << (IsValid ? "valid" : "DAMAGED") << "\n\n"
+			 << "Class 1: " << Census.SC1 << ", 1m: " << Census.SC1m << ", 2: " << Census.SC2 << ", 2m: " << Census.SC2m
+			 << ", 3: " << Census.SC3 << ", 3m: " << Census.SC3m << ", 6: " << Census.SC6 << ", 6m: " << Census.SC6m << "\n";
+
+		return IsValid ? 0 : 1;
+	}
+
+/* Way of Keeping Closed Polygons */
+	PolygonStorage Storage = StoreInMemory;
+	if (StreamPrefix != NULL)  Storage = StoreInRuns;
+	if (UseHashSet)  Storage = StoreInHashSet;
+
+	if (UseHashSet && (StreamPrefix != NULL))
+	{
+		cerr << "ERROR:  Options --stream and --hash exclude each other\n";
+		return 1;
+	}
+
+	if (InPlaceSort && (Storage != StoreInMemory))
+	{
+		cerr << "ERROR:  Option --in-place-sort excludes --stream and --hash\n";
+		return 1;
+	}
+
+/* Half-Chain Join and Transfer Matrix Run in One Go */
+	if (((Engine == EngineHalfChainJoin) || (Engine == EngineTransferMatrix)) && ((CheckpointFile != NULL) || (ResumeFile != NULL)))
+	{
+		cerr << "ERROR:  Checkpoints are not available with --engine join, transfer\n";
+		return 1;
+	}
+
+/* Transfer Matrix Keeps No Polygons */
+	if ((Engine == EngineTransferMatrix) && ((Storage != StoreInMemory) || InPlaceSort || (CatalogPrefix != NULL)))
+	{
+		cerr << "ERROR:  Options --stream, --hash, --in-place-sort and --catalog exclude --engine transfer\n";
+		return 1;
+	}
+
+/* Reduced Enumeration Skips Along the Codes */
+	if (Reversal && (Engine != EngineByCode))
+	{
+		cerr << "ERROR:  Reduced enumeration (--reversal) needs --engine code\n";
+		return 1;
+	}
+
+/* Statistics Need Complete Chains, and Are Not Kept in Checkpoints or the Results Table */
+	if (ChainStatistics && ((Engine == EngineHalfChainJoin) || (Engine == EngineTransferMatrix) || (CheckpointFile != NULL) || (ResumeFile != NULL) || (ResultsFile != NULL)))
+	{
+		cerr << "ERROR:  Option --chain-statistics excludes --engine join, transfer, checkpoints and --results\n";
+		return 1;
+	}
+
+/* One Way of Choosing Chain Lengths */
+	if ((Length != 0) && ((SweepFirst > 0) || (ResumeFile != NULL)))
+	{
+		cerr << "ERROR:  Option --length excludes --sweep and --resume\n";
+		return 1;
+	}
+
+/* Benchmark Runs All Engines on Chain Lengths of Its Own, From Scratch */
+	if ((BenchmarkFirst > 0) && ((SweepFirst > 0) || (Length != 0) || (CheckpointFile != NULL) || (ResumeFile != NULL)
+								 || (ResultsFile != NULL) || (FrontierPrefix != NULL)))
+	{
+		cerr << "ERROR:  Option --benchmark excludes --sweep, --length, checkpoints, --results and --frontier-cache\n";
+		return 1;
+	}
+
+	if ((BenchmarkFirst > 0) && (BenchmarkLast > MaxChainLength))
+	{
+		cerr << "ERROR:  Chain length must be 2 ... " << MaxChainLength << " (code engines up to " << MaxCodeLength << ")\n";
+		return 1;
+	}
+
+/* Format of Machine-Readable Results:  CSV for File Names Ending in .csv, JSON Otherwise */
+	if ((OutputFile != NULL) && (OutputFormat < 0))
+	{
+		std::basic_string<_TCHAR> Name = OutputFile;
+		OutputFormat = ((Name.size() >= 4) && (Name.compare(Name.size() - 4, 4, _T(".csv")) == 0)) ? 1 : 0;
+	}
+
+/* Sweeps Keep Finished Lengths in the Results Table Instead of Checkpoints */
+	if ((SweepFirst > 0) && ((CheckpointFile != NULL) || (ResumeFile != NULL)))
+	{
+		cerr << "ERROR:  Checkpoints are not available with --sweep (use --results to keep finished lengths)\n";
+		return 1;
+	}
+
+/* Keep Checkpointing Into the File a Run Was Resumed From */
+	if ((ResumeFile != NULL) && (CheckpointFile == NULL))  CheckpointFile = ResumeFile;
+
+/* Use All Available Cores on Request */
+	if (NumberOfThreads <= 0)
+	{
+		NumberOfThreads = (int)std::thread::hardware_concurrency();
+		if (NumberOfThreads <= 0)  NumberOfThreads = 1;
+	}
+
+/* State of an Interrupted Run */
+	CheckpointData Resumed;
+	Resumed.Storage = Storage;
+	Resumed.RunCount = 0;
+
+	if (ResumeFile != NULL)
+	{
+	/* Chain Length Is Taken From Checkpoint */
+		if (!ReadCheckpoint(ResumeFile, Resumed))
+		{
+			cerr << "ERROR:  Could not read checkpoint file\n";
+			return 1;
+		}
+
+		Length = Resumed.Length;
+
+	/* Polygons Must Be Kept the Same Way as Before */
+		if (Resumed.Storage != Storage)
+		{
+			cerr << "ERROR:  Polygon storage (--stream, --hash) must match the interrupted run\n";
+			return 1;
+		}
+
+	/* Chains Must Be Counted the Same Way as Before */
+		if ((Resumed.Reversal != 0) != Reversal)
+		{
+			cerr << "ERROR:  Reduced enumeration (--reversal) must match the interrupted run\n";
+			return 1;
+		}
+
+		cout << "Resuming chains of length " << Length << " from checkpoint\n\n";
+	}
+	else if ((SweepFirst == 0) && (BenchmarkFirst == 0) && (Length == 0))
+	{
+	/* Enter Maximum Chain Length Examined */
+		cout << "Enter Chain Length: ";
+		cin >> Length;
+		cout << "\n\n";
+	}
+
+/* Chain Lengths of the Run */
+	int FirstLength = Length, LastLength = Length;
+
+	if (SweepFirst > 0)
+	{
+		FirstLength = SweepFirst;
+		LastLength = SweepLast;
+	}
+
+/* Lengths Finished Before */
+	std::map<int, LengthResults> Table;
+	if (ResultsFile != NULL)  ReadResultsTable(ResultsFile, Table);
+
+/* Settings Shared by All Lengths */
+	RunOptions Options;
+	Options.NumberOfThreads = NumberOfThreads;
+	Options.PrefixBits = PrefixBits;
+	Options.CheckpointFile = CheckpointFile;
+	Options.CheckpointInterval = CheckpointInterval;
+	Options.ResumeFile = ResumeFile;
+	Options.StreamPrefix = StreamPrefix;
+	Options.RunBufferSize = RunBufferSize;
+	Options.Storage = Storage;
+	Options.Overlap = Overlap;
+	Options.Engine = Engine;
+	Options.Specialized = Specialized;
+	Options.TailBits = TailBits;
+	Options.Reversal = Reversal;
+	Options.FrontierPrefix = FrontierPrefix;
+	Options.FrontierDepth = FrontierDepth;
+	Options.CatalogPrefix = CatalogPrefix;
+	Options.CatalogSymmetry = CatalogSymmetry;
+	Options.ChainStatistics = ChainStatistics;
+	Options.InPlaceSort = InPlaceSort;
+	Options.TransferMemory = TransferMemory;
+
+/* Benchmark Instead of Counting Chains */
+	if (BenchmarkFirst > 0)  return RunBenchmark(BenchmarkFirst, BenchmarkLast, Options, OutputFile, OutputFormat == 1);
+
+/* Records of All Lengths, for Machine-Readable Results */
+	std::vector<LengthResults> Records;
+
+	for (Length = FirstLength; Length <= LastLength; ++Length)
+	{
+	/* Chains Beyond 64-Bit Codes:  Depth-First Search, Half-Chain Join, Transfer Matrix Only */
+		if ((Length < 2) || (Length > MaxChainLength) || ((Length > MaxCodeLength) && (Engine == EngineByCode)))
+		{
+			cerr << "ERROR:  Chain length must be 2 ... " << MaxCodeLength << " (up to " << MaxChainLength << " with --engine dfs, join, transfer)\n";
+			return 1;
+		}
+
+		if ((Length < 6) && (Engine == EngineHalfChainJoin))
+		{
+			cerr << "ERROR:  Half-chain join needs chains of at least 6 segments\n";
+			return 1;
+		}
+
+	/* Length Finished Before (an interrupted run is always completed) */
+		if ((ResumeFile == NULL) && (Table.count(Length) > 0))
+		{
+			cout << "(Results for chains of length " << Length << " taken from results table) \n";
+			PrintResults(Table[Length]);
+
+			Records.push_back(Table[Length]);
+			if (OutputFile != NULL)  WriteResultsFile(OutputFile, OutputFormat == 1, Records);
+			continue;
+		}
+
+		LengthResults Results;
+		EnumerateLength(Length, Options, Resumed, Results);
+		PrintResults(Results);
+
+	/* Rewrite Machine-Readable Results After Every Length */
+		Records.push_back(Results);
+		if (OutputFile != NULL)  WriteResultsFile(OutputFile, OutputFormat == 1, Records);
+
+	/* Keep Complete Results Only */
+		if ((ResultsFile != NULL) && Results.HasChains && Results.HasPolygons)
+		{
+			Table[Length] = Results;
+			if (!AppendResultsTable(ResultsFile, Results))  cerr << "WARNING:  Could not write results table\n";
+		}
+	}
 
 	return 0;
-}
\ No newline at end of file
+}
+
+#endif
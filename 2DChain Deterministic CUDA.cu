@@ -7,17 +7,66 @@
 
 	Rewritten to reflect number of segments rather than atoms, added minor improvements - March 2014
 
+	Pruned kernel:  Each thread examines a range of codes with the incremental algorithm of the CPU version
+	(rebuild of free ends, overlap check by distance, smart jump across overlapping chains)
+
+	Hybrid pipeline:  CPU threads enumerate self-avoiding prefixes, GPU streams expand their suffixes
+
+	Polygon output:  Primitive codes of closed chains are collected, sorted, and classified by symmetry on the GPU
+
+	Sharding:  Slices of the code space are handed out to all GPUs of a node, and across nodes via MPI
+
+	Persistent kernel:  Resident blocks pull tiles of work from a counter on the GPU, counts are copied back once per launch
+
+	Compact chains:  Kernels keep chains as packed 16-bit sites, with occupancy masks screening for overlaps
+
+	Specialized kernels:  Template instances for chains of 20 ... 62 segments, picked once at startup
+
+	Batch runs:  Chain length from the command line, results written as JSON or CSV (counts, symmetry classes, timings)
+
+	Wall time:  Phases timed by the steady clock (kernel runs do not use host processor time)
+
+	Known results:  Counts checked against an embedded table (lengths up to 42), so that no change goes unnoticed
+
 	By Christian Bracher */
 
 #include "cuda_runtime.h"
 #include "cuda_profiler_api.h"
 #include "device_launch_parameters.h"
 #include <stdio.h>
+#include <string.h>
 #include <iostream>
 
+/* Table of Known Results (shared with the CPU version) */
+
+#include "2DChain Known Results.h"
+
+/* Support for Hybrid CPU / GPU Pipeline */
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+/* Support for Sorting Polygon Codes on the GPU */
+
+#include <thrust/device_ptr.h>
+#include <thrust/sort.h>
+#include <thrust/unique.h>
+#include <algorithm>
+#include <iterator>
+
+/* Support for Multi-Node Runs (compile with USE_MPI) */
+
+#if defined (USE_MPI)
+#include <mpi.h>
+#endif
+
 /* Support for Timing */
 
 #include <time.h> 
+#include <chrono>
 
 /* Check for 64-bit support (necessary) */
 
@@ -43,6 +92,9 @@ using namespace std;
 	long NumberOfBlocks = ((long)1 << BlockBits);
 	const long MaxNumberOfBlocks = 65536;
 
+/* Pruned Kernel:  Maximum Number of Codes per Thread (default: 4096) */
+	const int MaxRangeBits = 12;
+
 	
 /* *** LATTICE VECTOR CLASS AND FUNCTIONS *** */
 
@@ -53,21 +105,21 @@ public:
 	int n1;
 	int n2;
 
-	__device__ LatticeVector ()
+	__host__ __device__ LatticeVector ()
 	{
 	/* Default Constructor */
 		n1 = 0;
 		n2 = 0;
 	}
 
-	__device__ LatticeVector (int x, int y)
+	__host__ __device__ LatticeVector (int x, int y)
 	{
 	/* Create a Lattice Point */
 		n1 = x;
 		n2 = y;
 	}
 
-	__device__ void LeftTurn (int orientation)
+	__host__ __device__ void LeftTurn (int orientation)
 	{
 	/* Calculates Grid Position of New Terminal Atom for a Left Turn, Assuming Bond Orientation d */
 		
@@ -99,7 +151,7 @@ public:
 		}
 	}
 
-	__device__ void RightTurn (int orientation)
+	__host__ __device__ void RightTurn (int orientation)
 	{
 	/* Calculates Grid Position of New Terminal Atom for a Right Turn, Assuming Bond Orientation d */
 		
@@ -131,7 +183,7 @@ public:
 		}
 	}
 
-	__device__ bool operator == (LatticeVector r1)
+	__host__ __device__ bool operator == (LatticeVector r1)
 	{
 	/* Compares Two Lattice Vectors */
 
@@ -141,11 +193,23 @@ public:
 
 		return IsEqual;
 	}
+
+	__host__ __device__ int distance (LatticeVector r1)
+	{
+	/* Finds Distance to Another Point in the Triangular Grid
+	   (a lower bound for the number of segments between two atoms) */
+
+		int d1 = r1.n1 - n1;
+		int d2 = r1.n2 - n2;
+
+		return (abs(d1) + abs(d2) + abs(d1 + d2)) / 2;
+	}
 };
 
-__device__ void BuildChain (uint64 Code, int length, LatticeVector *ChainArray)
+__host__ __device__ void BuildChain (uint64 Code, int length, LatticeVector *ChainArray)
 {
-/* Translate the Binary Code Into the Actual Lattice Points Occupied by the Chain */
+/* Translate the Binary Code Into the Actual Lattice Points Occupied by the Chain
+   (as in the CPU version, lowest bits indicate free end of chain) */
 
 	ChainArray[0] = LatticeVector(0,0);
 	ChainArray[1] = LatticeVector(1,0);
@@ -157,7 +221,7 @@ __device__ void BuildChain (uint64 Code, int length, LatticeVector *ChainArray)
 	{
 		ChainArray[k+1] = ChainArray[k];
 
-		if (((Code>>(k-2)) % 2) == 0)
+		if (((Code>>(length-k-1)) % 2) == 0)
 		{
 			ChainArray[k+1].LeftTurn(orientation);
 			++orientation;
@@ -214,193 +278,1766 @@ __device__ bool IsChainClosedLoop (int length, LatticeVector *ChainArray)
 	return true;
 }
 
-/* *** The ChainCounts Structure *** */
-	
-struct ChainCounts
+/* *** Incremental Chain Analysis (ported from CPU version) *** */
+
+__host__ __device__ int BranchingSegment (uint64 Code1, uint64 Code2, int length)
+{
+/* Find the Position of the First Segment That Deviates Between Two Chains */
+
+/* Find Difference in Bit Structure Using XOR */
+	uint64 DifferenceMap = (Code1 ^ Code2);
+
+/* Determine Starting Position of "Tail" To Be Changed, Using Bit Shifts */
+	int StartPos = length + 1;
+
+/* Find Largest Altered Bit */
+	do
 	{
-		unsigned long NonOverlapping;
-		unsigned long ClosedChains;
-	};
+		DifferenceMap >>= 1;
+		--StartPos;
+	}
+	while (DifferenceMap > 0);
 
-/* NEEDS TO BE ADAPTED... */ 
+	return StartPos;
+}
 
-void PrintChainArray (int length, LatticeVector* ChainArray)
+__host__ __device__ void RebuildChain (uint64 Code, int StartPos, int length, LatticeVector *ChainArray)
 {
-/* Print the Coordinates of the Atomic Grid Sites in the Chain */
+/* Reconstruct The Free End of an Existing Chain Under a Change of Code
+   StartPos Denotes the First Segment to Be Rebuilt */
 
-	for(int i=0; i <= length; ++i)
+/* Find Orientation of Segment at Start of Rebuild Section */
+	int orientation = 1;
+
+	for (int k = 3; k < StartPos; ++k)
 	{
-		cout << "(" << ChainArray[i].n1 << "," << ChainArray[i].n2 << ") ";
+		if (((Code>>(length-k)) % 2) == 0)
+			++orientation;
+		else
+			--orientation;
+	}
+
+/* Reconstruct End of Chain */
+	for (int k = StartPos; k <= length; ++k)
+	{
+		ChainArray[k] = ChainArray[k-1];
+
+		if (((Code>>(length-k)) % 2) == 0)
+		{
+			ChainArray[k].LeftTurn(orientation);
+			++orientation;
+		}
+		else
+		{
+			ChainArray[k].RightTurn(orientation);
+			--orientation;
+		}
 	}
-	cout << "\n";
 }
 
-/* *** Parallel Code for Chain Analysis *** */
+__host__ __device__ int ChainOverlap (int segment, int length, LatticeVector *ChainArray)
+{
+/* Find the First Overlap of Two "Atoms" in the Chain, Assuming None Up to Atom# (segment)
+   Function Value Returned is the Position of the Overlapping Atom (zero: no overlaps)
+   (the number of segments between two atoms is at least their distance) */
+
+	for (int k1 = segment; k1 <= length ; ++k1)
+	{
+		int k2 = 0;
+
+		while (k2 < k1 - 5)
+		{
+			int separation = ChainArray[k1].distance(ChainArray[k2]);
 
-__global__ void CUDAChainAnalyze(ChainCounts *CUDAChainInfo, uint64 CodeOffset, int ChainLength)
+			if (separation == 0)  return k1;
+
+			k2 += separation;
+		}
+	}
+
+	return 0;
+}
+
+/* *** Compact Chain Representation for the Kernels *** */
+
+/* Inside the kernels, a lattice site is packed into 16 bits as (n1 + SiteBias) * 256 + (n2 + SiteBias), so that a
+   chain takes 128 bytes instead of the 512 bytes of an array of LatticeVector.  A step along a segment adds a packed
+   offset, looked up in constant memory by turn and orientation (kept in the range 0...5).  Overlaps are screened by
+   two 64-bit occupancy masks in registers, one for each sublattice (atoms an odd number of segments apart never
+   meet):  only an atom whose bit is already set in the mask of its sublattice is compared with earlier atoms. */
+
+	const int SiteBias = 128;
+
+/* Steps Along a Segment by Turn (0: left, 1: right) and Orientation (packed n1 offset is 256) */
+	__constant__ short PackedStep[2][6] = {{ 1, -255, -256, -1, 255, 256 }, { 255, 256, 1, -255, -256, -1 }};
+
+/* Orientation of Next Segment by Turn and Orientation */
+	__constant__ unsigned char NextOrientation[2][6] = {{ 1, 2, 3, 4, 5, 0 }, { 5, 0, 1, 2, 3, 4 }};
+
+__device__ unsigned short PackSite (int n1, int n2)
 {
-/* Prepare Block Cache For Overlap Data */
-	__shared__ ChainCounts DataCache[MaxThreadsPerBlock];
+/* Pack Grid Coordinates of a Lattice Site Into 16 Bits */
+	return (unsigned short)(((n1 + SiteBias) << 8) + (n2 + SiteBias));
+}
 
-/* Allocate Memory for Building Chains (maximum length: 64) */
-	LatticeVector MyChainArray[64];
+__device__ int PackedDistance (unsigned int Site1, unsigned int Site2)
+{
+/* Distance Between Two Packed Sites in the Triangular Grid (see LatticeVector::distance) */
+	int d1 = (int)(Site1 >> 8) - (int)(Site2 >> 8);
+	int d2 = (int)(Site1 & 255) - (int)(Site2 & 255);
 
-/* Figure Out Correct Code For Two-Dimensional Chain */
-	uint64 MyCode = CodeOffset + (uint64)(threadIdx.x + blockIdx.x * blockDim.x);	
+	return (abs(d1) + abs(d2) + abs(d1 + d2)) / 2;
+}
 
-/* Build the Chain ... */
-	BuildChain(MyCode, ChainLength, MyChainArray);
+__device__ uint64 SiteBit (unsigned int Site)
+{
+/* Bit of a Site in the Occupancy Masks (sites within an 8x8 patch of the grid have different bits) */
+	return (uint64)1 << (((Site >> 8) + ((Site & 255) << 3)) & 63);
+}
 
-/* ... and Test It For Overlaps (default value: overlaps): */
-	DataCache[threadIdx.x].NonOverlapping = 0;
-	
-	if (IsChainOverlapping(ChainLength, MyChainArray) == false)
-		DataCache[threadIdx.x].NonOverlapping = 1;
-		
-/* ... and Test It For Closed Chains (default value: not closed): */
-	DataCache[threadIdx.x].ClosedChains = 0;
-	
-	if (IsChainClosedLoop(ChainLength, MyChainArray) == true)
-		DataCache[threadIdx.x].ClosedChains = 1;
-		
-/* Wait for Tests Within a Block To Be Completed */
-	__syncthreads();
+__device__ __forceinline__ void CompactRebuildChain (uint64 Code, int StartPos, int length, unsigned short *Sites)
+{
+/* Reconstruct The Free End of an Existing Chain Under a Change of Code
+   StartPos Denotes the First Segment to Be Rebuilt (at least 3) */
 
-/* Now, Add Results Within Block */
-	int AddLimit = blockDim.x / 2;
-	
-	while (AddLimit > 0)
+/* Orientation of Segment at Start of Rebuild Section:  Left Turns Minus Right Turns in Segments 3 ... StartPos-1 */
+	int Turns = StartPos - 3;
+	int RightTurns = __popcll((Code >> (length - StartPos + 1)) & (((uint64)1 << Turns) - 1));
+
+	int d = (1 + Turns - 2 * RightTurns) % 6;
+	if (d < 0) d += 6;
+
+/* Reconstruct End of Chain */
+	for (int k = StartPos; k <= length; ++k)
+	{
+		int Turn = (int)((Code >> (length - k)) & 1);
+
+		Sites[k] = (unsigned short)(Sites[k-1] + PackedStep[Turn][d]);
+		d = NextOrientation[Turn][d];
+	}
+}
+
+__device__ __forceinline__ void CompactBuildChain (uint64 Code, int length, unsigned short *Sites)
+{
+/* Translate the Binary Code Into the Packed Lattice Sites Occupied by the Chain (see BuildChain) */
+	Sites[0] = PackSite(0, 0);
+	Sites[1] = PackSite(1, 0);
+	Sites[2] = PackSite(1, 1);
+
+	CompactRebuildChain(Code, 3, length, Sites);
+}
+
+__device__ __forceinline__ int CompactChainOverlap (int segment, int length, const unsigned short *Sites)
+{
+/* Find the First Overlap of Two "Atoms" in the Chain, Assuming None Up to Atom# (segment)
+   Function Value Returned is the Position of the Overlapping Atom (zero: no overlaps)
+   (only atoms found in the occupancy mask are compared, using their distance to skip atoms) */
+
+/* Occupancy Masks of Atoms Known Not to Overlap */
+	uint64 EvenMask = 0;
+	uint64 OddMask = 0;
+
+	for (int k = 0; k < segment; ++k)
+	{
+		if (k & 1)
+			OddMask |= SiteBit(Sites[k]);
+		else
+			EvenMask |= SiteBit(Sites[k]);
+	}
+
+	for (int k1 = segment; k1 <= length; ++k1)
 	{
-		if (threadIdx.x < AddLimit)
+		uint64 Bit = SiteBit(Sites[k1]);
+
+		if (((k1 & 1) ? OddMask : EvenMask) & Bit)
 		{
-			DataCache[threadIdx.x].NonOverlapping += DataCache[threadIdx.x + AddLimit].NonOverlapping;
-			DataCache[threadIdx.x].ClosedChains   += DataCache[threadIdx.x + AddLimit].ClosedChains;
-		}
+		/* Possible Overlap:  Compare With Earlier Atoms */
+			int k2 = 0;
 
-		__syncthreads();
+			while (k2 < k1 - 5)
+			{
+				int separation = PackedDistance(Sites[k1], Sites[k2]);
+
+				if (separation == 0)  return k1;
+
+				k2 += separation;
+			}
+		}
 
-		AddLimit /= 2;
+		if (k1 & 1)
+			OddMask |= Bit;
+		else
+			EvenMask |= Bit;
 	}
 
-/* Store Result (now in position 0) in Global Memory */
-	if (threadIdx.x == 0)
+	return 0;
+}
+
+__device__ bool CompactClosedLoopCheck (int length, const unsigned short *Sites)
+{
+/* A Simplified Closed Loop Check that Assumes that The Overlapping Atom is the Final Atom in the Chain */
+
+	for (int k1 = length - 6; k1 > 0; --k1)
 	{
-		CUDAChainInfo[blockIdx.x].NonOverlapping = DataCache[0].NonOverlapping;
-		CUDAChainInfo[blockIdx.x].ClosedChains = DataCache[0].ClosedChains;
+		if (Sites[length] == Sites[k1]) return false;
 	}
+
+	return true;
 }
 
-/* *** TIMING FUNCTONS *** */
+/* *** POLYGON CODES ON THE GPU *** */
 
-double Duration (clock_t initial, clock_t final)
-{
-/* Determine the Duration of a Calculation in Seconds */
+/* Closed chains are turned into primitive polygon codes right away (same codes as PolyMath in the CPU version:
+   one bit per segment, smallest of all rotated and reverted versions), and appended to a device buffer.
+   After the enumeration, the buffer is sorted, freed of duplicates, and the symmetry class of every unique
+   polygon is determined - all on the GPU. */
+
+/* Append Buffer for Primitive Polygon Codes (PolygonBuffer is NULL if polygons are not kept) */
+	__device__ uint64 *PolygonBuffer;
+	__device__ unsigned long long PolygonCapacity;
+	__device__ unsigned long long PolygonCursor;
 
-	double TimeDiff = (double)(final - initial);
-	return TimeDiff / CLOCKS_PER_SEC;
+__device__ uint64 PolygonMask (int Length)
+{
+/* Template With One Bit Set per Segment */
+	return (((uint64)1 << Length) - 1);
 }
 
-/* *** MAIN PROGRAM STARTS HERE *** */
+__device__ uint64 RotatePolygon (uint64 Word, int Steps, int Length)
+{
+/* Rotate Polygon Code by a Number of Segments (0 <= Steps < Length) */
+	if (Steps == 0)  return Word;
+
+	return ((Word >> Steps) | (Word << (Length - Steps))) & PolygonMask(Length);
+}
 
-int main()
+__device__ uint64 MinimalRotation (uint64 Word, int Length)
 {
-	int Length;
-	clock_t StartTime, FinishTime;
-	double StartToFinish;
+/* Find Smallest Code Among All Rotated Versions of a Polygon Code
+   (only rotations starting with a longest run of left turns can be smallest) */
 
-/* Enter Chain Length Examined */
-	cout << "Enter Chain Length: ";
-	cin >> Length;
-	cout << "\n\n";
+	uint64 Mask = PolygonMask(Length);
+	uint64 Zeros = ~Word & Mask;
 
-/* Timing Support - Start of Calculation */
-	StartTime = clock();
+	if (Zeros == 0)  return Word;
 
-//	cudaProfilerStart();
-		
-/* Message */
-	cout << "Calculating chains of length " << Length << " : ";
+/* Positions Starting a Run of RunLength Zeros */
+	uint64 RunStarts = Zeros;
 
-/* There are 2^(l-2) Different Chains */ 
-	uint64 MaxCode = ((uint64)1 << (Length - 2));
+	for (int RunLength = 1; RunLength < Length; ++RunLength)
+	{
+		uint64 Longer = RunStarts & (((Zeros << RunLength) | (Zeros >> (Length - RunLength))) & Mask);
 
-/* Chop GPU Calculation Into Pieces If Length Exceeds ThreadBits + BlockBits + 2 */
-	uint64 CUDAIterations;
-	
-	if (MaxCode > (NumberOfBlocks * ThreadsPerBlock))
+		if (Longer == 0)  break;
+		RunStarts = Longer;
+	}
+
+/* Compare Candidates */
+	uint64 MinCode = Mask;
+
+	while (RunStarts != 0)
 	{
-	/* Number of Global Iterations */
-		CUDAIterations = ((MaxCode >> BlockBits) >> ThreadBits);
+		int Position = __ffsll((long long)RunStarts) - 1;
+		RunStarts &= (RunStarts - 1);
+
+		uint64 Candidate = RotatePolygon(Word, (Position + 1) % Length, Length);
+		if (Candidate < MinCode)  MinCode = Candidate;
 	}
-	else
+
+	return MinCode;
+}
+
+__device__ uint64 PrimitivePolygon (uint64 Code, int Length)
+{
+/* Turn the Code of a Closed Chain Into the Primitive Polygon Code (rotated/reverted version with smallest code) */
+
+/* Implicit Starting Turn is Left Turn (zero bit); Final Turn Follows From Orientation of Last Segment */
+	int orientation = 1;
+
+	for (int k = 3; k <= Length; ++k)
 	{
-	/* Adjust Number of Blocks */
-		CUDAIterations = 1;
-		NumberOfBlocks = (long)(MaxCode >> ThreadBits);
+		if (((Code >> (Length - k)) % 2) == 0)
+			++orientation;
+		else
+			--orientation;
+	}
+
+	int d = orientation % 6;
+	if (d < 0) d += 6;
+
+	uint64 Polygon = (Code << 1);
+	if (d == 1)  ++Polygon;
 
-	/* Check: There Must Be At Least As Many Chains As Threads */
-		if (NumberOfBlocks == 0)
+/* Reverted Polygon:  Reversed Reading Direction, Exchanged Turns */
+	uint64 Reverted = __brevll(~Polygon & PolygonMask(Length)) >> (64 - Length);
+
+	uint64 MinCode = MinimalRotation(Polygon, Length);
+	uint64 MinReverted = MinimalRotation(Reverted, Length);
+
+	return (MinReverted < MinCode) ? MinReverted : MinCode;
+}
+
+__device__ void AppendPolygon (uint64 Code, int Length)
+{
+/* Keep Primitive Code of a Closed Chain (codes beyond the capacity of the buffer are only counted) */
+	if (PolygonBuffer == NULL)  return;
+
+	unsigned long long Slot = atomicAdd(&PolygonCursor, 1ULL);
+	if (Slot < PolygonCapacity)  PolygonBuffer[Slot] = PrimitivePolygon(Code, Length);
+}
+
+__device__ int SymmetryClass (uint64 Code, int Length)
+{
+/* Symmetry Class of a Primitive Polygon:  0/1 (1, 1m), 2/3 (2, 2m), 4/5 (3, 3m), 6/7 (6, 6m) */
+
+/* Rotational Symmetry:  Length / (Shortest Period of Code) */
+	int RotSym = 1;
+
+	for (int Period = 1; Period < Length; ++Period)
+	{
+		if (((Length % Period) == 0) && (RotatePolygon(Code, Period, Length) == Code))
 		{
-			cerr << "ERROR:  Insufficient Length of Chain \n\n";
-			exit(1);
+			RotSym = Length / Period;
+			break;
 		}
 	}
-	
-/* Initialize Variable to Save Numbers of Non-Overlapping Chains, Closed Chains */
-	uint64 NonOverlapping = 0;
-	uint64 ClosedChains = 0;
 
-/* Reserve Memory to Transfer Information Between CPU and GPU */
-	ChainCounts *CPUChainInfo = new ChainCounts[NumberOfBlocks];
+/* Mirror Symmetry:  Inverted Code (reversed reading direction) Is a Rotated Version of the Original */
+	uint64 Inverted = __brevll(Code) >> (64 - Length);
+	bool MirrSymm = (MinimalRotation(Inverted, Length) == MinimalRotation(Code, Length));
 
-	ChainCounts *CUDAChainInfo; 
-	cudaError_t cudaStatus = cudaMalloc((void**)&CUDAChainInfo, NumberOfBlocks * sizeof(ChainCounts));
+	int Class = 0;
 
-/* Loop Through All Possible Configurations */
-	for (uint64 Iter = 0; Iter < CUDAIterations; ++Iter)
+	switch (RotSym)
 	{
-	/* Examine (ThreadsPerBlock * BlockNumber) Chains in Parallel */
+	case 2:
+		Class = 2;
+		break;
+	case 3:
+		Class = 4;
+		break;
+	case 6:
+		Class = 6;
+		break;
+	default:
+		break;
+	}
 
-	/* Determine Offset for Parallel Calculation */
-		uint64 Offset = Iter * NumberOfBlocks * ThreadsPerBlock;
+	return Class + (MirrSymm ? 1 : 0);
+}
 
-	/* Perform Parallel Analysis */
-		CUDAChainAnalyze <<<NumberOfBlocks,ThreadsPerBlock>>> (CUDAChainInfo, Offset, Length);
+/* *** The ChainCounts Structure *** */
+	
+struct ChainCounts
+	{
+		unsigned long long NonOverlapping;
+		unsigned long long ClosedChains;
+	};
 
-	/* Copy Results to Host Memory */
-		cudaStatus = cudaMemcpy(CPUChainInfo, CUDAChainInfo, NumberOfBlocks * sizeof(ChainCounts), cudaMemcpyDeviceToHost);
+__device__ __forceinline__ void AnalyzeCodeRange (uint64 FirstCode, uint64 EndCode, int ChainLength, unsigned short *Sites, ChainCounts &Counts)
+{
+/* Examine All Chains With FirstCode <= Code < EndCode, Count Non-Overlapping and Closed Chains */
 
-	/* Extract Information */
-		for (uint64 BlockID = 0; BlockID < NumberOfBlocks; ++BlockID)
+	Counts.NonOverlapping = 0;
+	Counts.ClosedChains = 0;
+
+	uint64 Code = FirstCode;
+	CompactBuildChain(Code, ChainLength, Sites);
+
+/* Chain With Opposite First Turn Forces Complete Check of Initial Chain */
+	uint64 LastCode = Code ^ ((uint64)1 << (ChainLength - 3));
+
+	do
+	{
+	/* Rebuild Chain From Branching Segment, Check for Overlaps */
+		int Segment = BranchingSegment(Code, LastCode, ChainLength);
+		CompactRebuildChain(Code, Segment, ChainLength, Sites);
+		int OverlapAt = CompactChainOverlap(Segment, ChainLength, Sites);
+
+		LastCode = Code;
+
+		if (OverlapAt == 0)
+		{
+			++Counts.NonOverlapping;
+			++Code;
+		}
+		else
 		{
-			NonOverlapping += (uint64)CPUChainInfo[BlockID].NonOverlapping;
-			ClosedChains   += (uint64)CPUChainInfo[BlockID].ClosedChains; 
+			if ((OverlapAt == ChainLength) && (CompactClosedLoopCheck(ChainLength, Sites) == true))
+			{
+				++Counts.ClosedChains;
+				AppendPolygon(Code, ChainLength);
+			}
+
+		/* Smart Jump to Next Code Without This Overlap */
+			Code >>= (ChainLength - OverlapAt);
+			++Code;
+			Code <<= (ChainLength - OverlapAt);
 		}
+	}
+	while (Code < EndCode);
+}
 
-	/* Indicate Progress */
-		cout << ".";
+/* NEEDS TO BE ADAPTED... */ 
+
+void PrintChainArray (int length, LatticeVector* ChainArray)
+{
+/* Print the Coordinates of the Atomic Grid Sites in the Chain */
+
+	for(int i=0; i <= length; ++i)
+	{
+		cout << "(" << ChainArray[i].n1 << "," << ChainArray[i].n2 << ") ";
 	}
+	cout << "\n";
+}
 
-	cudaDeviceReset();
+/* *** Parallel Code for Chain Analysis *** */
 
-/* Timing Support - End of Calculation */
-	FinishTime = clock();
-	StartToFinish = Duration(StartTime, FinishTime);
+/* Counts of the threads in a block are added with warp shuffles in registers (chains examined one per thread are
+   counted by warp votes instead), and only a single value per warp passes through shared memory. */
 
-/* Send a Brief Message */
-		cout << " done!\n\n"
-			 << "Found " << NonOverlapping << " non-overlapping chains.\n"
-			 << "Found " << ClosedChains << " closed chains \n\n"
-			 << "Time of Calculation: " << StartToFinish << " seconds.\n\n";
+__device__ int WarpWidth (void)
+{
+/* Number of Lanes Taking Part in Warp-Level Operations (blocks smaller than a warp use fewer lanes) */
+	return (blockDim.x < warpSize) ? (int)blockDim.x : warpSize;
+}
 
-/* Wait for Key: */
-	char Aux;
-	cout << "Hit A Key, Then ENTER\n\n";
-	cin >> Aux; 
+__device__ unsigned int WarpMask (void)
+{
+/* Lanes Taking Part in Warp-Level Operations */
+	return (WarpWidth() == 32) ? 0xffffffffu : ((1u << WarpWidth()) - 1);
+}
 
-/* Cleanup & Done! */
-	delete[] CPUChainInfo;
-	cudaFree(CUDAChainInfo);
+__device__ unsigned long long WarpSum (unsigned long long Value)
+{
+/* Add Values of All Lanes in a Warp (result is valid in lane 0) */
+	for (int Offset = WarpWidth() / 2; Offset > 0; Offset /= 2)
+	{
+		Value += __shfl_down_sync(WarpMask(), Value, Offset, WarpWidth());
+	}
 
-	return 0;
+	return Value;
+}
+
+__device__ void AddWarpCounts (ChainCounts WarpCounts, ChainCounts *CUDAChainInfo)
+{
+/* Add Counts of All Warps in Block (valid in lane 0 of each warp), Store Result in Global Memory */
+	__shared__ ChainCounts WarpCache[MaxThreadsPerBlock / 32];
+
+	int Lane = threadIdx.x % warpSize;
+	int Warp = threadIdx.x / warpSize;
+
+	if (Lane == 0)  WarpCache[Warp] = WarpCounts;
+	__syncthreads();
+
+/* First Warp Adds Counts of All Warps */
+	if (Warp == 0)
+	{
+		int NumberOfWarps = (blockDim.x + warpSize - 1) / warpSize;
+
+		ChainCounts BlockCounts = {0, 0};
+		if (Lane < NumberOfWarps)  BlockCounts = WarpCache[Lane];
+
+		BlockCounts.NonOverlapping = WarpSum(BlockCounts.NonOverlapping);
+		BlockCounts.ClosedChains   = WarpSum(BlockCounts.ClosedChains);
+
+		if (Lane == 0)  CUDAChainInfo[blockIdx.x] = BlockCounts;
+	}
+}
+
+__device__ void ReduceBlockCounts (ChainCounts MyCounts, ChainCounts *CUDAChainInfo)
+{
+/* Add Counts of All Threads in Block, Store Result in Global Memory */
+	MyCounts.NonOverlapping = WarpSum(MyCounts.NonOverlapping);
+	MyCounts.ClosedChains   = WarpSum(MyCounts.ClosedChains);
+
+	AddWarpCounts(MyCounts, CUDAChainInfo);
+}
+
+__device__ void ReduceBlockFlags (bool NonOverlapping, bool ClosedChain, ChainCounts *CUDAChainInfo)
+{
+/* Count Chains in Block With Properties Set (one chain per thread) by Warp Votes, Store Result in Global Memory */
+	ChainCounts WarpCounts;
+
+	WarpCounts.NonOverlapping = (unsigned long long)__popc(__ballot_sync(WarpMask(), NonOverlapping));
+	WarpCounts.ClosedChains   = (unsigned long long)__popc(__ballot_sync(WarpMask(), ClosedChain));
+
+	AddWarpCounts(WarpCounts, CUDAChainInfo);
+}
+
+template <int N>
+__global__ void CUDAChainAnalyze(ChainCounts *CUDAChainInfo, uint64 CodeOffset, int RuntimeLength)
+{
+/* Length of Chains:  Compile-Time Constant in Specialized Instances */
+	const int ChainLength = (N > 0) ? N : RuntimeLength;
+
+/* Packed Sites of Chain (maximum length: 63) */
+	unsigned short MySites[64];
+
+/* Figure Out Correct Code For Two-Dimensional Chain */
+	uint64 MyCode = CodeOffset + (uint64)(threadIdx.x + blockIdx.x * blockDim.x);	
+
+/* Build the Chain ... */
+	CompactBuildChain(MyCode, ChainLength, MySites);
+
+/* ... and Test It For Overlaps ... */
+	int OverlapAt = CompactChainOverlap(3, ChainLength, MySites);
+	bool NonOverlapping = (OverlapAt == 0);
+		
+/* ... and Test It For Closed Chains: */
+	bool ClosedChain = (OverlapAt == ChainLength) && CompactClosedLoopCheck(ChainLength, MySites);
+	
+	if (ClosedChain)  AppendPolygon(MyCode, ChainLength);
+		
+/* Count Results Within Block, Store Them in Global Memory */
+	ReduceBlockFlags(NonOverlapping, ClosedChain, CUDAChainInfo);
+}
+
+template <int N>
+__global__ void CUDAChainAnalyzePruned(ChainCounts *CUDAChainInfo, uint64 RangeOffset, int RangeBits, int RuntimeLength)
+{
+/* Length of Chains:  Compile-Time Constant in Specialized Instances */
+	const int ChainLength = (N > 0) ? N : RuntimeLength;
+
+/* Packed Sites of Chain (maximum length: 63) */
+	unsigned short MySites[64];
+
+/* Figure Out Code Range of This Thread */
+	uint64 FirstCode = (RangeOffset + (uint64)(threadIdx.x + blockIdx.x * blockDim.x)) << RangeBits;
+
+/* Examine Chains in Range, Skipping Known Overlaps */
+	ChainCounts MyCounts;
+	AnalyzeCodeRange(FirstCode, FirstCode + ((uint64)1 << RangeBits), ChainLength, MySites, MyCounts);
+
+/* Add Results Within Block, Store Them in Global Memory */
+	ReduceBlockCounts(MyCounts, CUDAChainInfo);
+}
+
+template <int N>
+__global__ void CUDAExpandPrefixes(ChainCounts *CUDAChainInfo, const uint64 *Prefixes, int NumberOfPrefixes, int SubRangeBits, int RangeBits, int RuntimeLength)
+{
+/* Length of Chains:  Compile-Time Constant in Specialized Instances */
+	const int ChainLength = (N > 0) ? N : RuntimeLength;
+
+/* Packed Sites of Chain (maximum length: 63) */
+	unsigned short MySites[64];
+
+/* Figure Out Prefix and Sub-Range of Suffix Codes for This Thread */
+	uint64 MyItem = (uint64)(threadIdx.x + blockIdx.x * blockDim.x);
+	uint64 MyPrefix = (MyItem >> SubRangeBits);
+
+	ChainCounts MyCounts = {0, 0};
+
+	if (MyPrefix < (uint64)NumberOfPrefixes)
+	{
+		uint64 SubRange = MyItem & (((uint64)1 << SubRangeBits) - 1);
+		uint64 FirstCode = (Prefixes[MyPrefix] << (SubRangeBits + RangeBits)) | (SubRange << RangeBits);
+
+		AnalyzeCodeRange(FirstCode, FirstCode + ((uint64)1 << RangeBits), ChainLength, MySites, MyCounts);
+	}
+
+/* Add Results Within Block, Store Them in Global Memory */
+	ReduceBlockCounts(MyCounts, CUDAChainInfo);
+}
+
+template <int N>
+__global__ void CUDAChainAnalyzePersistent(unsigned long long *CUDATotals, unsigned long long *NextTile, uint64 EndTile, int RangeBits, int RuntimeLength, bool UsePrunedKernel)
+{
+/* Persistent Kernel:  Resident Blocks Pull Tiles of blockDim.x Work Items From a Global Counter Until None Are Left,
+   Counts Are Kept in Registers and Added to the Global 64-Bit Totals Once at the End (one atomic update per warp) */
+
+/* Length of Chains:  Compile-Time Constant in Specialized Instances */
+	const int ChainLength = (N > 0) ? N : RuntimeLength;
+
+
+/* Tile Shared by All Threads of the Block */
+	__shared__ unsigned long long BlockTile;
+
+/* Packed Sites of Chain (maximum length: 63) */
+	unsigned short MySites[64];
+
+	unsigned long long NonOverlapping = 0;
+	unsigned long long ClosedChains = 0;
+
+	while (true)
+	{
+	/* Take Next Tile */
+		if (threadIdx.x == 0)  BlockTile = atomicAdd(NextTile, 1ULL);
+		__syncthreads();
+
+		uint64 MyTile = (uint64)BlockTile;
+		__syncthreads();
+
+		if (MyTile >= EndTile)  break;
+
+		uint64 MyItem = MyTile * blockDim.x + threadIdx.x;
+
+		if (UsePrunedKernel)
+		{
+		/* Examine Chains in Range, Skipping Known Overlaps */
+			ChainCounts RangeCounts;
+			uint64 FirstCode = (MyItem << RangeBits);
+
+			AnalyzeCodeRange(FirstCode, FirstCode + ((uint64)1 << RangeBits), ChainLength, MySites, RangeCounts);
+
+			NonOverlapping += RangeCounts.NonOverlapping;
+			ClosedChains += RangeCounts.ClosedChains;
+		}
+		else
+		{
+		/* Build the Chain, and Test It For Overlaps and Closed Chains */
+			CompactBuildChain(MyItem, ChainLength, MySites);
+
+			int OverlapAt = CompactChainOverlap(3, ChainLength, MySites);
+
+			if (OverlapAt == 0)  ++NonOverlapping;
+
+			if ((OverlapAt == ChainLength) && CompactClosedLoopCheck(ChainLength, MySites))
+			{
+				++ClosedChains;
+				AppendPolygon(MyItem, ChainLength);
+			}
+		}
+	}
+
+/* Add Results Within Warp, Add Them to Global Totals */
+	NonOverlapping = WarpSum(NonOverlapping);
+	ClosedChains = WarpSum(ClosedChains);
+
+	if ((threadIdx.x % warpSize) == 0)
+	{
+		if (NonOverlapping > 0)  atomicAdd(&CUDATotals[0], NonOverlapping);
+		if (ClosedChains > 0)  atomicAdd(&CUDATotals[1], ClosedChains);
+	}
+}
+
+/* *** KERNELS SPECIALIZED ON CHAIN LENGTH *** */
+
+/* The chain kernels are templates on the number of segments N.  In an instance with N > 0, the length is a
+   compile-time constant in the inlined chain functions, so that the compiler knows loop limits and shift amounts.
+   Instances for MinFixedLength ... MaxFixedLength segments are collected in a table on the host; the kernels used
+   for a run are picked there once, and launched through function pointers.  N = 0 is the generic instance. */
+
+	const int MinFixedLength = 20;
+	const int MaxFixedLength = 62;
+
+struct KernelSet
+{
+/* Kernels for the Chains of One Length */
+	void (*Analyze) (ChainCounts*, uint64, int);
+	void (*Pruned) (ChainCounts*, uint64, int, int);
+	void (*Expand) (ChainCounts*, const uint64*, int, int, int, int);
+	void (*Persistent) (unsigned long long*, unsigned long long*, uint64, int, int, bool);
+};
+
+/* Kernels Used in This Run */
+	KernelSet Kernels;
+
+template <int N>
+KernelSet KernelInstance (void)
+{
+/* Collect Kernels Specialized for Chains of N Segments (N = 0: generic kernels) */
+	KernelSet Set;
+
+	Set.Analyze = CUDAChainAnalyze<N>;
+	Set.Pruned = CUDAChainAnalyzePruned<N>;
+	Set.Expand = CUDAExpandPrefixes<N>;
+	Set.Persistent = CUDAChainAnalyzePersistent<N>;
+
+	return Set;
+}
+
+template <int N>
+struct KernelInstances
+{
+	static void Fill (KernelSet *Table)
+	{
+	/* Enter Instance for N Segments, Continue With N - 1 */
+		Table[N - MinFixedLength] = KernelInstance<N>();
+
+		KernelInstances<N - 1>::Fill(Table);
+	}
+};
+
+template <>
+struct KernelInstances<MinFixedLength - 1>
+{
+	static void Fill (KernelSet *)
+	{
+	/* All Instances Entered */
+	}
+};
+
+KernelSet SelectKernels (int Length, bool Specialized)
+{
+/* Find Kernels for Chains of Given Length:  Specialized Instance If Available, Generic Instance Otherwise */
+	if (Specialized && (Length >= MinFixedLength) && (Length <= MaxFixedLength))
+	{
+		KernelSet Table[MaxFixedLength - MinFixedLength + 1];
+		KernelInstances<MaxFixedLength>::Fill(Table);
+
+		return Table[Length - MinFixedLength];
+	}
+
+	return KernelInstance<0>();
+}
+
+__global__ void CUDASymmetryCensus(unsigned long long *ClassCounts, const uint64 *Codes, uint64 NumberOfCodes, int Length)
+{
+/* Count Unique Polygons by Symmetry Class (grid-stride loop), Add Counts of Block to Global Counters */
+	__shared__ unsigned int BlockCounts[8];
+
+	for (int c = threadIdx.x; c < 8; c += blockDim.x)  BlockCounts[c] = 0;
+	__syncthreads();
+
+	for (uint64 i = (uint64)(threadIdx.x + blockIdx.x * blockDim.x); i < NumberOfCodes; i += (uint64)blockDim.x * gridDim.x)
+	{
+		atomicAdd(&BlockCounts[SymmetryClass(Codes[i], Length)], 1u);
+	}
+
+	__syncthreads();
+
+	for (int c = threadIdx.x; c < 8; c += blockDim.x)  atomicAdd(&ClassCounts[c], (unsigned long long)BlockCounts[c]);
+}
+
+uint64 *OpenPolygonBuffer (unsigned long long &Capacity)
+{
+/* Reserve Buffer for Primitive Polygon Codes on the Current GPU, Make It Known to the Kernels
+   (capacity is reset to zero if the memory is not available) */
+
+	uint64 *CUDAPolygons = NULL;
+	unsigned long long Cursor = 0;
+
+	if (Capacity > 0)
+	{
+		if (cudaMalloc((void**)&CUDAPolygons, Capacity * sizeof(uint64)) != cudaSuccess)
+		{
+			cerr << "WARNING:  Could not reserve GPU memory for polygon codes, polygons are not kept \n";
+			CUDAPolygons = NULL;
+			Capacity = 0;
+		}
+	}
+
+	cudaMemcpyToSymbol(PolygonBuffer, &CUDAPolygons, sizeof(uint64*));
+	cudaMemcpyToSymbol(PolygonCapacity, &Capacity, sizeof(unsigned long long));
+	cudaMemcpyToSymbol(PolygonCursor, &Cursor, sizeof(unsigned long long));
+
+	return CUDAPolygons;
+}
+
+bool ClosePolygonBuffer (uint64 *CUDAPolygons, unsigned long long Capacity, std::vector<uint64> &Polygons)
+{
+/* Sort Polygon Codes in Buffer of the Current GPU, Eliminate Duplicates, Copy Unique Codes to Host, Release Buffer
+   Function Value Returned Indicates Whether All Polygons Were Kept */
+
+	if (CUDAPolygons == NULL)  return false;
+
+	unsigned long long PolygonsFound = 0;
+	cudaMemcpyFromSymbol(&PolygonsFound, PolygonCursor, sizeof(unsigned long long));
+
+	bool PolygonsKept = (PolygonsFound <= Capacity);
+
+	if (PolygonsKept)
+	{
+	/* Device Radix Sort and Unique Pass */
+		thrust::device_ptr<uint64> First(CUDAPolygons);
+
+		thrust::sort(First, First + PolygonsFound);
+		uint64 UniquePolygons = (uint64)(thrust::unique(First, First + PolygonsFound) - First);
+
+		Polygons.resize(UniquePolygons);
+		if (UniquePolygons > 0)  cudaMemcpy(&Polygons[0], CUDAPolygons, UniquePolygons * sizeof(uint64), cudaMemcpyDeviceToHost);
+	}
+	else
+	{
+		cerr << "\nWARNING:  " << PolygonsFound << " closed chains exceed the polygon buffer (use --polygon-buffer) \n";
+	}
+
+	cudaFree(CUDAPolygons);
+
+	return PolygonsKept;
+}
+
+void MergePolygons (std::vector<uint64> &Polygons, const std::vector<uint64> &MorePolygons)
+{
+/* Merge Two Sorted Lists of Unique Polygon Codes Into One (codes found in both lists are kept once) */
+	std::vector<uint64> Merged;
+	Merged.reserve(Polygons.size() + MorePolygons.size());
+
+	std::set_union(Polygons.begin(), Polygons.end(), MorePolygons.begin(), MorePolygons.end(), std::back_inserter(Merged));
+	Polygons.swap(Merged);
+}
+
+void CensusPolygons (const std::vector<uint64> &Polygons, int Length, uint64 *ClassCounts)
+{
+/* Count Unique Polygons by Symmetry Class on the Current GPU */
+
+	for (int c = 0; c < 8; ++c)  ClassCounts[c] = 0;
+	if (Polygons.empty())  return;
+
+	uint64 *CUDAPolygons;
+	cudaMalloc((void**)&CUDAPolygons, Polygons.size() * sizeof(uint64));
+	cudaMemcpy(CUDAPolygons, &Polygons[0], Polygons.size() * sizeof(uint64), cudaMemcpyHostToDevice);
+
+	unsigned long long *CUDAClassCounts;
+	cudaMalloc((void**)&CUDAClassCounts, 8 * sizeof(unsigned long long));
+	cudaMemset(CUDAClassCounts, 0, 8 * sizeof(unsigned long long));
+
+	CUDASymmetryCensus <<<NumberOfBlocks,ThreadsPerBlock>>> (CUDAClassCounts, CUDAPolygons, (uint64)Polygons.size(), Length);
+
+	unsigned long long CPUClassCounts[8];
+	cudaMemcpy(CPUClassCounts, CUDAClassCounts, 8 * sizeof(unsigned long long), cudaMemcpyDeviceToHost);
+
+	cudaFree(CUDAClassCounts);
+	cudaFree(CUDAPolygons);
+
+	for (int c = 0; c < 8; ++c)  ClassCounts[c] = (uint64)CPUClassCounts[c];
+}
+
+/* *** HYBRID CPU / GPU PIPELINE *** */
+
+/* CPU threads enumerate the self-avoiding prefixes (first PrefixLength segments) of all chains with the
+   incremental algorithm, and pass them on in batches through pinned host buffers.  The GPU expands every
+   prefix into its 2^(Length - PrefixLength) suffixes.  Each batch is copied and analyzed asynchronously in
+   one of several CUDA streams, so that the CPU fills new buffers while the GPU works on earlier ones.
+   Since the suffix check needs all atoms of the prefix, the GPU rebuilds them from the prefix code. */
+
+/* Number of CUDA Streams, Maximum Prefixes per Batch */
+	const int HybridStreams = 2;
+	const int MaxPrefixBatch = (1 << 16);
+
+struct PrefixBatch
+{
+/* Codes of Self-Avoiding Prefixes (pinned host memory) */
+	uint64 *Codes;
+	int Count;
+};
+
+class PrefixPipeline
+{
+/* Hands Batches of Prefixes From the CPU Producer Threads to the GPU, and Empty Buffers Back */
+public:
+	std::vector<PrefixBatch> Batch;
+	int BatchCapacity;
+
+	std::mutex Lock;
+	std::condition_variable Changed;
+	std::deque<int> Empty;
+	std::deque<int> Full;
+	int ActiveProducers;
+
+	int TakeEmpty (void)
+	{
+	/* Wait for an Empty Buffer (the GPU sets the pace) */
+		std::unique_lock<std::mutex> Guard(Lock);
+		while (Empty.empty())  Changed.wait(Guard);
+
+		int b = Empty.front();
+		Empty.pop_front();
+
+		Batch[b].Count = 0;
+		return b;
+	}
+
+	void ReturnEmpty (int b)
+	{
+		std::lock_guard<std::mutex> Guard(Lock);
+		Empty.push_back(b);
+		Changed.notify_all();
+	}
+
+	void PushFull (int b)
+	{
+		std::lock_guard<std::mutex> Guard(Lock);
+		Full.push_back(b);
+		Changed.notify_all();
+	}
+
+	bool TakeFull (int &b)
+	{
+	/* Wait for a Filled Buffer; False If All Producers Are Done */
+		std::unique_lock<std::mutex> Guard(Lock);
+		while (Full.empty() && (ActiveProducers > 0))  Changed.wait(Guard);
+
+		if (Full.empty())  return false;
+
+		b = Full.front();
+		Full.pop_front();
+		return true;
+	}
+
+	void ProducerDone (void)
+	{
+		std::lock_guard<std::mutex> Guard(Lock);
+		--ActiveProducers;
+		Changed.notify_all();
+	}
+};
+
+void ProducePrefixes (PrefixPipeline *Pipeline, int PrefixLength, uint64 FirstCode, uint64 EndCode)
+{
+/* CPU Thread:  Find All Self-Avoiding Prefixes With FirstCode <= Code < EndCode (rebuild, overlap check, smart jump) */
+
+	LatticeVector ChainArray[64];
+
+	int b = Pipeline->TakeEmpty();
+
+	uint64 Code = FirstCode;
+	BuildChain(Code, PrefixLength, ChainArray);
+	uint64 LastCode = Code ^ ((uint64)1 << (PrefixLength - 3));
+
+	while (Code < EndCode)
+	{
+		int Segment = BranchingSegment(Code, LastCode, PrefixLength);
+		RebuildChain(Code, Segment, PrefixLength, ChainArray);
+		int OverlapAt = ChainOverlap(Segment, PrefixLength, ChainArray);
+
+		LastCode = Code;
+
+		if (OverlapAt == 0)
+		{
+		/* Viable Prefix:  Add to Batch, Hand Over Full Batches */
+			PrefixBatch &Batch = Pipeline->Batch[b];
+			Batch.Codes[Batch.Count++] = Code;
+
+			if (Batch.Count == Pipeline->BatchCapacity)
+			{
+				Pipeline->PushFull(b);
+				b = Pipeline->TakeEmpty();
+			}
+
+			++Code;
+		}
+		else
+		{
+		/* Smart Jump (prefixes closing a loop overlap in longer chains) */
+			Code >>= (PrefixLength - OverlapAt);
+			++Code;
+			Code <<= (PrefixLength - OverlapAt);
+		}
+	}
+
+/* Hand Over Last Batch */
+	if (Pipeline->Batch[b].Count > 0)
+		Pipeline->PushFull(b);
+	else
+		Pipeline->ReturnEmpty(b);
+
+	Pipeline->ProducerDone();
+}
+
+void RunHybridPipeline (int Length, int PrefixLength, int CPUThreads, uint64 &NonOverlapping, uint64 &ClosedChains)
+{
+/* Examine All Chains With CPU Threads Producing Prefixes, GPU Streams Expanding Them */
+
+/* Split Suffix Codes Into Sub-Ranges (one per GPU thread) of 2^RangeBits Codes */
+	int SuffixBits = Length - PrefixLength;
+
+	int RangeBits = SuffixBits;
+	if (RangeBits > MaxRangeBits)  RangeBits = MaxRangeBits;
+
+	int SubRangeBits = SuffixBits - RangeBits;
+	if (SubRangeBits > BlockBits + ThreadBits)
+	{
+	/* Keep a Single Prefix Within One Launch */
+		SubRangeBits = BlockBits + ThreadBits;
+		RangeBits = SuffixBits - SubRangeBits;
+	}
+
+/* Prefixes per Batch:  One Launch Covers a Batch */
+	PrefixPipeline Pipeline;
+
+	Pipeline.BatchCapacity = (int)((((uint64)NumberOfBlocks * ThreadsPerBlock) >> SubRangeBits));
+	if (Pipeline.BatchCapacity > MaxPrefixBatch)  Pipeline.BatchCapacity = MaxPrefixBatch;
+	if (Pipeline.BatchCapacity < 1)  Pipeline.BatchCapacity = 1;
+
+	long MaxBlocks = (long)((((uint64)Pipeline.BatchCapacity << SubRangeBits) + ThreadsPerBlock - 1) / ThreadsPerBlock);
+
+/* One Buffer Being Filled by Each CPU Thread, Two per Stream (one in flight, one waiting) */
+	uint64 MaxPrefixCode = ((uint64)1 << (PrefixLength - 2));
+	if ((uint64)CPUThreads > MaxPrefixCode)  CPUThreads = (int)MaxPrefixCode;
+
+	Pipeline.Batch.resize(CPUThreads + 2 * HybridStreams);
+
+	for (int b = 0; b < (int)Pipeline.Batch.size(); ++b)
+	{
+		cudaHostAlloc((void**)&Pipeline.Batch[b].Codes, Pipeline.BatchCapacity * sizeof(uint64), cudaHostAllocDefault);
+		Pipeline.Batch[b].Count = 0;
+		Pipeline.Empty.push_back(b);
+	}
+
+/* Device Buffers, Pinned Buffers for Block Counts, and Batch in Flight for Each Stream */
+	cudaStream_t Stream[HybridStreams];
+	uint64 *CUDAPrefixes[HybridStreams];
+	ChainCounts *CUDAChainInfo[HybridStreams];
+	ChainCounts *CPUChainInfo[HybridStreams];
+	int InFlight[HybridStreams];
+	long BlocksInFlight[HybridStreams];
+
+	for (int s = 0; s < HybridStreams; ++s)
+	{
+		cudaStreamCreate(&Stream[s]);
+		cudaMalloc((void**)&CUDAPrefixes[s], Pipeline.BatchCapacity * sizeof(uint64));
+		cudaMalloc((void**)&CUDAChainInfo[s], MaxBlocks * sizeof(ChainCounts));
+		cudaHostAlloc((void**)&CPUChainInfo[s], MaxBlocks * sizeof(ChainCounts), cudaHostAllocDefault);
+		InFlight[s] = -1;
+	}
+
+/* Start CPU Producers, Each on a Contiguous Part of the Prefix Code Space */
+	Pipeline.ActiveProducers = CPUThreads;
+
+	std::vector<std::thread> Producers;
+
+	for (int t = 0; t < CPUThreads; ++t)
+	{
+		Producers.push_back(std::thread(ProducePrefixes, &Pipeline, PrefixLength,
+			(MaxPrefixCode * t) / CPUThreads, (MaxPrefixCode * (t + 1)) / CPUThreads));
+	}
+
+/* Feed Batches to the Streams in Turn */
+	int s = 0;
+	int b;
+	bool IsDrained = false;
+
+	while (!IsDrained)
+	{
+		IsDrained = !Pipeline.TakeFull(b);
+
+	/* Wait for Previous Batch of Stream, Collect Counts, Recycle Its Buffer */
+		for (int i = 0; i < (IsDrained ? HybridStreams : 1); ++i)
+		{
+			int r = (s + i) % HybridStreams;
+			if (InFlight[r] < 0)  continue;
+
+			cudaStreamSynchronize(Stream[r]);
+
+			for (long BlockID = 0; BlockID < BlocksInFlight[r]; ++BlockID)
+			{
+				NonOverlapping += (uint64)CPUChainInfo[r][BlockID].NonOverlapping;
+				ClosedChains   += (uint64)CPUChainInfo[r][BlockID].ClosedChains;
+			}
+
+			Pipeline.ReturnEmpty(InFlight[r]);
+			InFlight[r] = -1;
+		}
+
+		if (IsDrained)  break;
+
+	/* Copy Prefixes, Expand Them, Copy Block Counts Back (all asynchronous within the stream) */
+		int Count = Pipeline.Batch[b].Count;
+		long Blocks = (long)((((uint64)Count << SubRangeBits) + ThreadsPerBlock - 1) / ThreadsPerBlock);
+
+		cudaMemcpyAsync(CUDAPrefixes[s], Pipeline.Batch[b].Codes, Count * sizeof(uint64), cudaMemcpyHostToDevice, Stream[s]);
+		Kernels.Expand <<<Blocks,ThreadsPerBlock,0,Stream[s]>>> (CUDAChainInfo[s], CUDAPrefixes[s], Count, SubRangeBits, RangeBits, Length);
+		cudaMemcpyAsync(CPUChainInfo[s], CUDAChainInfo[s], Blocks * sizeof(ChainCounts), cudaMemcpyDeviceToHost, Stream[s]);
+
+		InFlight[s] = b;
+		BlocksInFlight[s] = Blocks;
+
+		s = (s + 1) % HybridStreams;
+
+	/* Indicate Progress */
+		cout << ".";
+	}
+
+	for (int t = 0; t < CPUThreads; ++t)  Producers[t].join();
+
+/* Cleanup */
+	for (int i = 0; i < HybridStreams; ++i)
+	{
+		cudaStreamDestroy(Stream[i]);
+		cudaFree(CUDAPrefixes[i]);
+		cudaFree(CUDAChainInfo[i]);
+		cudaFreeHost(CPUChainInfo[i]);
+	}
+
+	for (size_t i = 0; i < Pipeline.Batch.size(); ++i)  cudaFreeHost(Pipeline.Batch[i].Codes);
+}
+
+/* *** MULTI-GPU AND MULTI-NODE SHARDING *** */
+
+/* The code space is cut into slices of (NumberOfBlocks * ThreadsPerBlock) work items, the work of a single kernel
+   launch.  Every GPU is driven by a host thread of its own that takes the next open slice from a common dispenser as
+   soon as its last slice is done, so faster devices simply examine more slices.  In multi-node runs (compiled with
+   USE_MPI, one process per node) the dispenser is a counter on rank 0, shared through a one-sided MPI window by
+   all GPUs of all ranks.  Every GPU sorts its own polygon codes and removes duplicates; the sorted lists of all
+   devices and ranks are finally merged into a single list on rank 0. */
+
+/* Number of Polygon Codes per MPI Message */
+	const int PolygonsPerMessage = (1 << 24);
+
+class SliceDispenser
+{
+/* Hands Out Slices of the Code Space to the GPUs, One at a Time */
+
+public:
+	uint64 NumberOfSlices;
+	uint64 NextSlice;
+	bool ShowProgress;
+
+	std::mutex Lock;
+
+#if defined (USE_MPI)
+	MPI_Win Window;
+	uint64 *SharedCounter;
+#endif
+
+	void Open (uint64 Slices, int Rank)
+	{
+	/* Prepare Dispenser for All Slices (collective call in multi-node runs) */
+		NumberOfSlices = Slices;
+		NextSlice = 0;
+		ShowProgress = (Rank == 0);
+
+	#if defined (USE_MPI)
+		MPI_Win_allocate((Rank == 0) ? sizeof(uint64) : 0, sizeof(uint64), MPI_INFO_NULL, MPI_COMM_WORLD, &SharedCounter, &Window);
+		if (Rank == 0)  *SharedCounter = 0;
+		MPI_Barrier(MPI_COMM_WORLD);
+	#endif
+	}
+
+	void Close (void)
+	{
+	/* Release Dispenser (collective call in multi-node runs) */
+	#if defined (USE_MPI)
+		MPI_Win_free(&Window);
+	#endif
+	}
+
+	bool Take (uint64 &Slice, uint64 &Count, uint64 Wanted)
+	{
+	/* Get Next Open Slices (up to Wanted of them, Count is the number obtained)
+	   Function Value Returned is False When All Slices Are Taken */
+		std::lock_guard<std::mutex> Guard(Lock);
+
+	#if defined (USE_MPI)
+		MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, Window);
+		MPI_Fetch_and_op(&Wanted, &Slice, MPI_UINT64_T, 0, 0, MPI_SUM, Window);
+		MPI_Win_unlock(0, Window);
+	#else
+		Slice = NextSlice;
+		NextSlice += Wanted;
+	#endif
+
+		if (Slice >= NumberOfSlices)  return false;
+
+		Count = ((NumberOfSlices - Slice) < Wanted) ? (NumberOfSlices - Slice) : Wanted;
+		return true;
+	}
+
+	void Done (void)
+	{
+	/* Indicate Progress */
+		std::lock_guard<std::mutex> Guard(Lock);
+
+		if (ShowProgress)  cout << "." << flush;
+	}
+};
+
+struct DeviceResult
+{
+/* Counts, Sorted Unique Polygon Codes Found by One GPU */
+	uint64 NonOverlapping;
+	uint64 ClosedChains;
+
+	bool PolygonsKept;
+	std::vector<uint64> Polygons;
+};
+
+int ResidentBlocks (int Device)
+{
+/* Number of Blocks of the Persistent Kernel That Can Be Resident on a GPU at the Same Time */
+	cudaDeviceProp Properties;
+	cudaGetDeviceProperties(&Properties, Device);
+
+	int BlocksPerProcessor = 0;
+	cudaOccupancyMaxActiveBlocksPerMultiprocessor(&BlocksPerProcessor, Kernels.Persistent, ThreadsPerBlock, 0);
+	if (BlocksPerProcessor < 1)  BlocksPerProcessor = 1;
+
+	return Properties.multiProcessorCount * BlocksPerProcessor;
+}
+
+void RunDeviceWorker (int Device, SliceDispenser *Dispenser, int Length, bool UsePrunedKernel, int RangeBits,
+					  int SlicesPerLaunch, unsigned long long BufferCapacity, DeviceResult *Result)
+{
+/* Examine Slices of the Code Space on One GPU Until None Are Left
+   (SlicesPerLaunch > 0:  persistent kernel examines that many slices per launch, tiles are taken on the GPU) */
+
+	cudaSetDevice(Device);
+
+	Result->NonOverlapping = 0;
+	Result->ClosedChains = 0;
+
+/* Reserve Memory to Transfer Information Between CPU and GPU */
+	ChainCounts *CPUChainInfo = new ChainCounts[NumberOfBlocks];
+
+	ChainCounts *CUDAChainInfo;
+	cudaMalloc((void**)&CUDAChainInfo, NumberOfBlocks * sizeof(ChainCounts));
+
+	uint64 *CUDAPolygons = OpenPolygonBuffer(BufferCapacity);
+
+/* Persistent Kernel:  Tile Counter and 64-Bit Totals on the GPU */
+	unsigned long long *CUDATotals = NULL;
+	unsigned long long *CUDANextTile = NULL;
+	long PersistentBlocks = 0;
+
+	if (SlicesPerLaunch > 0)
+	{
+		cudaMalloc((void**)&CUDATotals, 2 * sizeof(unsigned long long));
+		cudaMalloc((void**)&CUDANextTile, sizeof(unsigned long long));
+		PersistentBlocks = ResidentBlocks(Device);
+	}
+
+/* Loop Through Slices */
+	uint64 Slice, Count;
+
+	while ((SlicesPerLaunch > 0) && Dispenser->Take(Slice, Count, (uint64)SlicesPerLaunch))
+	{
+	/* Tiles of ThreadsPerBlock Work Items in Slices Taken */
+		unsigned long long FirstTile = Slice * NumberOfBlocks;
+		uint64 EndTile = (Slice + Count) * NumberOfBlocks;
+
+		long Blocks = (PersistentBlocks < (long)(EndTile - FirstTile)) ? PersistentBlocks : (long)(EndTile - FirstTile);
+
+		cudaMemset(CUDATotals, 0, 2 * sizeof(unsigned long long));
+		cudaMemcpy(CUDANextTile, &FirstTile, sizeof(unsigned long long), cudaMemcpyHostToDevice);
+
+		Kernels.Persistent <<<Blocks,ThreadsPerBlock>>> (CUDATotals, CUDANextTile, EndTile, RangeBits, Length, UsePrunedKernel);
+
+	/* Copy Results to Host Memory (only at the end of each launch) */
+		unsigned long long Totals[2];
+		cudaMemcpy(Totals, CUDATotals, 2 * sizeof(unsigned long long), cudaMemcpyDeviceToHost);
+
+		Result->NonOverlapping += (uint64)Totals[0];
+		Result->ClosedChains   += (uint64)Totals[1];
+
+		Dispenser->Done();
+	}
+
+	while ((SlicesPerLaunch == 0) && Dispenser->Take(Slice, Count, 1))
+	{
+	/* Examine (ThreadsPerBlock * BlockNumber) Chains in Parallel */
+
+	/* Determine Offset for Parallel Calculation */
+		uint64 Offset = Slice * NumberOfBlocks * ThreadsPerBlock;
+
+	/* Perform Parallel Analysis */
+		if (UsePrunedKernel)
+			Kernels.Pruned <<<NumberOfBlocks,ThreadsPerBlock>>> (CUDAChainInfo, Offset, RangeBits, Length);
+		else
+			Kernels.Analyze <<<NumberOfBlocks,ThreadsPerBlock>>> (CUDAChainInfo, Offset, Length);
+
+	/* Copy Results to Host Memory */
+		cudaMemcpy(CPUChainInfo, CUDAChainInfo, NumberOfBlocks * sizeof(ChainCounts), cudaMemcpyDeviceToHost);
+
+	/* Extract Information */
+		for (uint64 BlockID = 0; BlockID < NumberOfBlocks; ++BlockID)
+		{
+			Result->NonOverlapping += (uint64)CPUChainInfo[BlockID].NonOverlapping;
+			Result->ClosedChains   += (uint64)CPUChainInfo[BlockID].ClosedChains; 
+		}
+
+		Dispenser->Done();
+	}
+
+/* Sort Polygon Codes Found on This GPU, Eliminate Duplicates */
+	Result->PolygonsKept = ClosePolygonBuffer(CUDAPolygons, BufferCapacity, Result->Polygons);
+
+	delete[] CPUChainInfo;
+	cudaFree(CUDAChainInfo);
+	cudaFree(CUDATotals);
+	cudaFree(CUDANextTile);
+}
+
+#if defined (USE_MPI)
+
+void GatherPolygons (int Rank, int NumberOfRanks, std::vector<uint64> &Polygons)
+{
+/* Merge Sorted Lists of Unique Polygon Codes of All Ranks Into the List on Rank 0 */
+
+	if (Rank == 0)
+	{
+		for (int Source = 1; Source < NumberOfRanks; ++Source)
+		{
+		/* Receive List of Codes in Pieces */
+			uint64 Count;
+			MPI_Recv(&Count, 1, MPI_UINT64_T, Source, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+			std::vector<uint64> MorePolygons(Count);
+
+			for (uint64 Done = 0; Done < Count; Done += PolygonsPerMessage)
+			{
+				int Piece = (int)((Count - Done < (uint64)PolygonsPerMessage) ? (Count - Done) : PolygonsPerMessage);
+				MPI_Recv(&MorePolygons[Done], Piece, MPI_UINT64_T, Source, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			}
+
+			MergePolygons(Polygons, MorePolygons);
+		}
+	}
+	else
+	{
+	/* Send List of Codes in Pieces */
+		uint64 Count = Polygons.size();
+		MPI_Send(&Count, 1, MPI_UINT64_T, 0, 0, MPI_COMM_WORLD);
+
+		for (uint64 Done = 0; Done < Count; Done += PolygonsPerMessage)
+		{
+			int Piece = (int)((Count - Done < (uint64)PolygonsPerMessage) ? (Count - Done) : PolygonsPerMessage);
+			MPI_Send(&Polygons[Done], Piece, MPI_UINT64_T, 0, 1, MPI_COMM_WORLD);
+		}
+
+		Polygons.clear();
+	}
+}
+
+#endif
+
+/* *** KNOWN RESULTS *** */
+
+/* Counts of chains, closed chains and polygons by symmetry class for all lengths up to 42 (Bracher, May 4, 2014),
+   in "2DChain Known Results.h", shared with the CPU version.  Every run checks its results against this table;
+   a mismatch makes the program return a failure status. */
+
+int CheckAgainstReference (int Length, uint64 NonOverlapping, uint64 ClosedChains, bool PolygonsKept,
+						   uint64 UniquePolygons, const uint64 *ClassCounts)
+{
+/* Compare Results of a Run With the Known Results (polygons not kept are left out)
+   Function Value Returned:  0 = all counts agree, 1 = some count differs, 2 = length not in table */
+	for (int i = 0; i < KnownLengths; ++i)
+	{
+		const ReferenceCounts &Known = KnownResults[i];
+		if (Known.Length != Length)  continue;
+
+		if ((NonOverlapping != Known.NonOverlaps) || (ClosedChains != Known.ClosedChains))  return 1;
+
+		if (PolygonsKept)
+		{
+			if (UniquePolygons != Known.UniquePolygons)  return 1;
+			for (int k = 0; k < 8; ++k)
+			{
+				if (ClassCounts[k] != Known.Classes[k])  return 1;
+			}
+		}
+
+		return 0;
+	}
+
+	return 2;
+}
+
+
+/* *** TIMING FUNCTONS *** */
+
+/* Points in Time of the Steady Clock */
+typedef std::chrono::steady_clock::time_point TimePoint;
+
+inline TimePoint Now ()
+{
+	return std::chrono::steady_clock::now();
+}
+
+double Duration (TimePoint initial, TimePoint final)
+{
+/* Determine the Duration of a Calculation in Seconds */
+
+	return std::chrono::duration<double>(final - initial).count();
+}
+
+void WriteResultsFile (const char *FileName, bool AsCSV, int Length, uint64 NonOverlapping, uint64 ClosedChains,
+					   bool PolygonsKept, uint64 UniquePolygons, const uint64 *ClassCounts, double EnumerationSeconds, double CensusSeconds,
+					   int Check)
+{
+/* Machine-Readable Results (JSON object, or CSV with header line; polygons not kept are left empty or null) */
+
+	FILE *File = fopen(FileName, "w");
+	if (File == NULL)
+	{
+		cerr << "WARNING:  Could not write results file\n";
+		return;
+	}
+
+	const char *Names[16] = {"Length", "NonOverlaps", "ClosedChains", "UniquePolygons",
+							 "SC1", "SC1m", "SC2", "SC2m", "SC3", "SC3m", "SC6", "SC6m",
+							 "EnumerationSeconds", "AnalysisSeconds", "Source", "Check"};
+	const char *Checks[3] = {"passed", "FAILED", "unknown"};
+
+/* Fields as Text, in the Order of Names */
+	char Field[16][32];
+
+	sprintf(Field[0], "%d", Length);
+	sprintf(Field[1], "%llu", (unsigned long long)NonOverlapping);
+	sprintf(Field[2], "%llu", (unsigned long long)ClosedChains);
+	sprintf(Field[3], "%llu", (unsigned long long)UniquePolygons);
+	for (int k = 0; k < 8; ++k)  sprintf(Field[4 + k], "%llu", (unsigned long long)ClassCounts[k]);
+	sprintf(Field[12], "%.3f", EnumerationSeconds);
+	sprintf(Field[13], "%.3f", CensusSeconds);
+	sprintf(Field[14], AsCSV ? "%s" : "\"%s\"", "computed");
+	sprintf(Field[15], AsCSV ? "%s" : "\"%s\"", Checks[Check]);
+
+	if (!PolygonsKept)
+	{
+		for (int k = 3; k < 12; ++k)  strcpy(Field[k], AsCSV ? "" : "null");
+	}
+
+	if (AsCSV)
+	{
+		for (int k = 0; k < 16; ++k)  fprintf(File, (k == 0) ? "%s" : ",%s", Names[k]);
+		fprintf(File, "\n");
+		for (int k = 0; k < 16; ++k)  fprintf(File, (k == 0) ? "%s" : ",%s", Field[k]);
+		fprintf(File, "\n");
+	}
+	else
+	{
+		fprintf(File, "[\n  {");
+		for (int k = 0; k < 16; ++k)  fprintf(File, "%s\"%s\": %s", (k == 0) ? "" : ", ", Names[k], Field[k]);
+		fprintf(File, "}\n]\n");
+	}
+
+	if ((ferror(File) != 0) | (fclose(File) != 0))  cerr << "WARNING:  Could not write results file\n";
+}
+
+/* *** MAIN PROGRAM STARTS HERE *** */
+
+int main(int argc, char* argv[])
+{
+	int Length = 0;
+	TimePoint StartTime, FinishTime;
+	double StartToFinish;
+
+/* Multi-Node Runs:  Rank of This Process, Number of Processes */
+	int Rank = 0;
+	int NumberOfRanks = 1;
+
+#if defined (USE_MPI)
+	int ThreadSupport;
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &ThreadSupport);
+	MPI_Comm_rank(MPI_COMM_WORLD, &Rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &NumberOfRanks);
+
+/* Slices Are Taken by One Host Thread per GPU:  MPI Must Allow Calls From Several Threads, One at a Time */
+	if (ThreadSupport < MPI_THREAD_SERIALIZED)
+	{
+		if (Rank == 0)  cerr << "ERROR:  MPI library does not support calls from several threads (MPI_THREAD_SERIALIZED) \n\n";
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+#endif
+
+/* Command Line Options:  Brute Force Kernel (every chain checked in full) Instead of Pruned Kernel,
+   Hybrid Pipeline With Prefixes of Given Length Found by CPU Threads, Number of CPU Threads,
+   Size of GPU Buffer for Polygon Codes in MB (0: polygons are not kept), Number of GPUs Used per Node,
+   Persistent Kernel With Given Number of Slices per Launch (0: one launch per slice), Generic Kernels for All Lengths,
+   Chain Length (0: from input, then wait for a key at the end), File and Format of Machine-Readable Results */
+	bool UsePrunedKernel = true;
+	bool Specialized = true;
+	int SlicesPerLaunch = 0;
+	int PolygonBufferMB = 512;
+	int PrefixLength = 0;
+	const char *OutputFile = NULL;
+	int OutputFormat = -1;
+	int CPUThreads = (int)std::thread::hardware_concurrency();
+	if (CPUThreads <= 0)  CPUThreads = 1;
+
+	int NumberOfDevices = 0;
+	cudaGetDeviceCount(&NumberOfDevices);
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--brute-force") == 0)
+		{
+			UsePrunedKernel = false;
+		}
+		else if (strcmp(argv[i], "--generic") == 0)
+		{
+			Specialized = false;
+		}
+		else if ((strcmp(argv[i], "--hybrid") == 0) && (i + 1 < argc))
+		{
+			PrefixLength = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--cpu-threads") == 0) && (i + 1 < argc))
+		{
+			CPUThreads = atoi(argv[++i]);
+			if (CPUThreads <= 0)  CPUThreads = 1;
+		}
+		else if ((strcmp(argv[i], "--polygon-buffer") == 0) && (i + 1 < argc))
+		{
+			PolygonBufferMB = atoi(argv[++i]);
+			if (PolygonBufferMB < 0)  PolygonBufferMB = 0;
+		}
+		else if ((strcmp(argv[i], "--devices") == 0) && (i + 1 < argc))
+		{
+			int RequestedDevices = atoi(argv[++i]);
+			if ((RequestedDevices > 0) && (RequestedDevices < NumberOfDevices))  NumberOfDevices = RequestedDevices;
+		}
+		else if ((strcmp(argv[i], "--persistent") == 0) && (i + 1 < argc))
+		{
+			SlicesPerLaunch = atoi(argv[++i]);
+			if (SlicesPerLaunch < 0)  SlicesPerLaunch = 0;
+		}
+		else if ((strcmp(argv[i], "--length") == 0) && (i + 1 < argc))
+		{
+			Length = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--output") == 0) && (i + 1 < argc))
+		{
+			OutputFile = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--format") == 0) && (i + 1 < argc) && (strcmp(argv[i + 1], "json") == 0))
+		{
+			OutputFormat = 0;
+			++i;
+		}
+		else if ((strcmp(argv[i], "--format") == 0) && (i + 1 < argc) && (strcmp(argv[i + 1], "csv") == 0))
+		{
+			OutputFormat = 1;
+			++i;
+		}
+		else
+		{
+			if (Rank == 0)
+				cerr << "Usage: 2DChain [--brute-force] [--hybrid PREFIX-SEGMENTS] [--cpu-threads N] [--polygon-buffer MB] [--devices N] [--persistent SLICES] [--generic]\n"
+					 << "               [--length N] [--output FILE] [--format json|csv (default: from file name)]\n";
+			return 1;
+		}
+	}
+
+	if (NumberOfDevices <= 0)
+	{
+		cerr << "ERROR:  No GPU found \n\n";
+		exit(1);
+	}
+
+/* Format of Machine-Readable Results:  CSV for File Names Ending in .csv, JSON Otherwise */
+	if ((OutputFile != NULL) && (OutputFormat < 0))
+	{
+		size_t NameLength = strlen(OutputFile);
+		OutputFormat = ((NameLength >= 4) && (strcmp(OutputFile + NameLength - 4, ".csv") == 0)) ? 1 : 0;
+	}
+
+/* Enter Chain Length Examined Unless Given (rank 0 asks, and tells all other ranks) */
+	bool IsInteractive = (Length == 0);
+
+	if (IsInteractive && (Rank == 0))
+	{
+		cout << "Enter Chain Length: ";
+		cin >> Length;
+		cout << "\n\n";
+	}
+
+#if defined (USE_MPI)
+	MPI_Bcast(&Length, 1, MPI_INT, 0, MPI_COMM_WORLD);
+#endif
+
+/* Kernels for Chains of This Length */
+	Kernels = SelectKernels(Length, Specialized);
+
+	if ((PrefixLength != 0) && ((PrefixLength < 3) || (PrefixLength >= Length)))
+	{
+		cerr << "ERROR:  Prefix length must be at least 3, and shorter than the chain \n\n";
+		exit(1);
+	}
+
+	if ((PrefixLength != 0) && (NumberOfRanks > 1))
+	{
+		if (Rank == 0)  cerr << "ERROR:  The hybrid pipeline runs in a single process \n\n";
+		exit(1);
+	}
+
+/* Timing Support - Start of Calculation */
+	StartTime = Now();
+
+//	cudaProfilerStart();
+		
+/* Message */
+	if (Rank == 0)  cout << "Calculating chains of length " << Length << " : ";
+
+/* There are 2^(l-2) Different Chains */ 
+	uint64 MaxCode = ((uint64)1 << (Length - 2));
+
+/* Initialize Variable to Save Numbers of Non-Overlapping Chains, Closed Chains */
+	uint64 NonOverlapping = 0;
+	uint64 ClosedChains = 0;
+
+/* Size of Device Buffers for Primitive Codes of Closed Chains */
+	unsigned long long BufferCapacity = ((unsigned long long)PolygonBufferMB << 20) / sizeof(uint64);
+
+/* Sorted Unique Polygon Codes */
+	bool PolygonsKept = (BufferCapacity > 0);
+	std::vector<uint64> Polygons;
+
+	if (PrefixLength > 0)
+	{
+	/* Hybrid Pipeline:  CPU Threads Find Prefixes, GPU Streams Expand Them (first GPU only) */
+		cudaSetDevice(0);
+		NumberOfDevices = 1;
+
+		uint64 *CUDAPolygons = OpenPolygonBuffer(BufferCapacity);
+
+		RunHybridPipeline(Length, PrefixLength, CPUThreads, NonOverlapping, ClosedChains);
+
+		PolygonsKept = ClosePolygonBuffer(CUDAPolygons, BufferCapacity, Polygons);
+	}
+	else
+	{
+	/* Pruned Kernel:  Every Thread Examines a Range of 2^RangeBits Codes */
+		int RangeBits = 0;
+
+		if (UsePrunedKernel)
+		{
+			RangeBits = Length - 2 - BlockBits - ThreadBits;
+			if (RangeBits < 0)  RangeBits = 0;
+			if (RangeBits > MaxRangeBits)  RangeBits = MaxRangeBits;
+		}
+
+		uint64 WorkItems = (MaxCode >> RangeBits);
+
+	/* Chop GPU Calculation Into Slices If Length Exceeds ThreadBits + BlockBits + RangeBits + 2 */
+		uint64 CUDAIterations;
+	
+		if (WorkItems > (NumberOfBlocks * ThreadsPerBlock))
+		{
+		/* Number of Global Iterations */
+			CUDAIterations = ((WorkItems >> BlockBits) >> ThreadBits);
+		}
+		else
+		{
+		/* Adjust Number of Blocks */
+			CUDAIterations = 1;
+			NumberOfBlocks = (long)(WorkItems >> ThreadBits);
+
+		/* Check: There Must Be At Least As Many Chains As Threads */
+			if (NumberOfBlocks == 0)
+			{
+				cerr << "ERROR:  Insufficient Length of Chain \n\n";
+				exit(1);
+			}
+		}
+
+	/* Hand Out Slices to All GPUs of All Ranks */
+		SliceDispenser Dispenser;
+		Dispenser.Open(CUDAIterations, Rank);
+
+		std::vector<DeviceResult> Results(NumberOfDevices);
+		std::vector<std::thread> Workers;
+
+		for (int Device = 0; Device < NumberOfDevices; ++Device)
+			Workers.push_back(std::thread(RunDeviceWorker, Device, &Dispenser, Length, UsePrunedKernel, RangeBits, SlicesPerLaunch, BufferCapacity, &Results[Device]));
+
+		for (int Device = 0; Device < NumberOfDevices; ++Device)
+			Workers[Device].join();
+
+		Dispenser.Close();
+
+	/* Collect Counts, Merge Sorted Polygon Codes of All GPUs */
+		for (int Device = 0; Device < NumberOfDevices; ++Device)
+		{
+			NonOverlapping += Results[Device].NonOverlapping;
+			ClosedChains += Results[Device].ClosedChains;
+
+			PolygonsKept = PolygonsKept && Results[Device].PolygonsKept;
+			if (PolygonsKept)  MergePolygons(Polygons, Results[Device].Polygons);
+
+			std::vector<uint64>().swap(Results[Device].Polygons);
+		}
+	}
+
+#if defined (USE_MPI)
+/* Add Counts of All Ranks, Merge Sorted Polygon Codes on Rank 0 */
+	uint64 RankCounts[2] = {NonOverlapping, ClosedChains};
+	uint64 TotalCounts[2] = {0, 0};
+
+	MPI_Reduce(RankCounts, TotalCounts, 2, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+	NonOverlapping = TotalCounts[0];
+	ClosedChains = TotalCounts[1];
+
+	int RankKept = PolygonsKept ? 1 : 0;
+	int AllKept = 0;
+
+	MPI_Allreduce(&RankKept, &AllKept, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+	PolygonsKept = (AllKept == 1);
+
+	if (PolygonsKept)  GatherPolygons(Rank, NumberOfRanks, Polygons);
+#endif
+
+/* Timing Support - End of Enumeration */
+	TimePoint CensusTime = Now();
+	double EnumerationSeconds = Duration(StartTime, CensusTime);
+
+/* Examine Symmetry of Unique Polygons (on first GPU of rank 0) */
+	uint64 UniquePolygons = (uint64)Polygons.size();
+	uint64 ClassCounts[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+	if (PolygonsKept && (Rank == 0))
+	{
+		cudaSetDevice(0);
+		CensusPolygons(Polygons, Length, ClassCounts);
+	}
+
+	double CensusSeconds = Duration(CensusTime, Now());
+
+	for (int Device = 0; Device < NumberOfDevices; ++Device)
+	{
+		cudaSetDevice(Device);
+		cudaDeviceReset();
+	}
+
+/* Timing Support - End of Calculation */
+	FinishTime = Now();
+	StartToFinish = Duration(StartTime, FinishTime);
+
+#if defined (USE_MPI)
+	MPI_Finalize();
+#endif
+
+	if (Rank != 0)  return 0;
+
+/* Send a Brief Message */
+		cout << " done!\n\n"
+			 << "Found " << NonOverlapping << " non-overlapping chains.\n"
+			 << "Found " << ClosedChains << " closed chains \n\n";
+
+
+/* Unique Polygons, Symmetry Classes */
+	if (PolygonsKept)
+	{
+		cout << "Number of Unique Polygons: " << UniquePolygons << " (includes mirror symmetric pairs)\n\n";
+
+		cout << "Self-Avoiding Polygon(s) By Symmetry Class: \n\n";
+
+		cout << "Class 1  (trivial symmetry group) ............... " << ClassCounts[0] << "\n"
+			 << "Class 1m (only mirror symmetry) ................. " << ClassCounts[1] << "\n"
+			 << "Class 2  (symmetry under 180 deg rotations) ..... " << ClassCounts[2] << "\n"
+			 << "Class 2m (180 deg rotation & mirror symmetry) ... " << ClassCounts[3] << "\n"
+			 << "Class 3  (symmetry under 120 deg rotations) ..... " << ClassCounts[4] << "\n"
+			 << "Class 3m (120 deg rotation & mirror symmetry) ... " << ClassCounts[5] << "\n"
+			 << "Class 6  (symmetry under 60 deg rotations) ...... " << ClassCounts[6] << "\n"
+			 << "Class 6m (60 deg rotation & mirror symmetry) .... " << ClassCounts[7] << "\n\n";
+	}
+
+	cout << "Time of Calculation: " << StartToFinish << " seconds.\n\n";
+
+/* Check Against Known Results */
+	int Check = CheckAgainstReference(Length, NonOverlapping, ClosedChains, PolygonsKept, UniquePolygons, ClassCounts);
+
+	if (Check == 1)
+		cout << "ERROR:  Counts differ from the known results\n\n";
+	else if (Check == 0)
+		cout << "All counts agree with the known results\n\n";
+
+	if (OutputFile != NULL)
+	{
+		WriteResultsFile(OutputFile, OutputFormat == 1, Length, NonOverlapping, ClosedChains,
+						 PolygonsKept, UniquePolygons, ClassCounts, EnumerationSeconds, CensusSeconds, Check);
+	}
+
+/* Wait for Key (interactive runs only): */
+	if (IsInteractive)
+	{
+		char Aux;
+		cout << "Hit A Key, Then ENTER\n\n";
+		cin >> Aux;
+	}
+
+/* Done! */
+	return (Check == 1) ? 1 : 0;
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+/*  *** 2D CHAIN KNOWN RESULTS ***
+
+	Counts of Self-Avoiding Chains, Closed Chains and Unique Polygons by Symmetry Class on the 2D Honeycomb
+	Lattice, for All Lengths up to 42 (Bracher, May 4, 2014)
+
+	The one copy of the published counts, shared by the CPU version (benchmark suite) and the CUDA version
+	(check of every run). */
+
+#ifndef TWODCHAIN_KNOWN_RESULTS_H
+#define TWODCHAIN_KNOWN_RESULTS_H
+
+struct ReferenceCounts
+{
+/* Known Results for One Chain Length (no closed chains for odd lengths) */
+	int Length;
+	unsigned long long NonOverlaps;
+	unsigned long long ClosedChains;
+	unsigned long long UniquePolygons;
+	unsigned long long Classes[8];
+};
+
+const ReferenceCounts KnownResults[] =
+{
+	{ 2, 1ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{ 3, 2ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{ 4, 4ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{ 5, 8ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{ 6, 15ULL, 1, 1, {0, 0, 0, 0, 0, 0, 0, 1}},
+	{ 7, 29ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{ 8, 56ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{ 9, 108ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{10, 203ULL, 5, 1, {0, 0, 0, 1, 0, 0, 0, 0}},
+	{11, 388ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{12, 736ULL, 4, 1, {0, 0, 0, 0, 0, 1, 0, 0}},
+	{13, 1398ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{14, 2630ULL, 28, 3, {0, 1, 0, 2, 0, 0, 0, 0}},
+	{15, 4982ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{16, 9378ULL, 48, 3, {2, 1, 0, 0, 0, 0, 0, 0}},
+	{17, 17700ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{18, 33225ULL, 195, 16, {4, 3, 4, 2, 0, 2, 0, 1}},
+	{19, 62584ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{20, 117384ULL, 460, 23, {18, 5, 0, 0, 0, 0, 0, 0}},
+	{21, 220666ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{22, 413282ULL, 1584, 80, {50, 14, 10, 6, 0, 0, 0, 0}},
+	{23, 775744ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{24, 1451702ULL, 4296, 183, {168, 9, 0, 0, 4, 2, 0, 0}},
+	{25, 2721370ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{26, 5087729ULL, 14001, 563, {462, 52, 40, 9, 0, 0, 0, 0}},
+	{27, 9526928ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{28, 17799014ULL, 40684, 1453, {1418, 35, 0, 0, 0, 0, 0, 0}},
+	{29, 33298068ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{30, 62166075ULL, 129995, 4415, {4114, 144, 124, 15, 10, 6, 0, 2}},
+	{31, 116202999ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{32, 216825708ULL, 392800, 12275, {12178, 97, 0, 0, 0, 0, 0, 0}},
+	{33, 405008856ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{34, 755302825ULL, 1247885, 36917, {36006, 482, 400, 29, 0, 0, 0, 0}},
+	{35, 1409930613ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{36, 2628181908ULL, 3861276, 107289, {106952, 290, 0, 0, 40, 7, 0, 0}},
+	{37, 4903287880ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{38, 9136005987ULL, 12273221, 323627, {320882, 1450, 1242, 53, 0, 0, 0, 0}},
+	{39, 17036013381ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{40, 31730100342ULL, 38558000, 963950, {963068, 882, 0, 0, 0, 0, 0, 0}},
+	{41, 59140552046ULL, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}},
+	{42, 110111883195ULL, 122953089, 2929563, {2920880, 4515, 3940, 86, 116, 21, 2, 3}}
+};
+
+const int KnownLengths = sizeof(KnownResults) / sizeof(ReferenceCounts);
+
+#endif
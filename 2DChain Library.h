@@ -0,0 +1,64 @@
+/*  *** 2D CHAIN LIBRARY INTERFACE ***
+
+	Chains on the 2D Honeycomb Lattice, for Use From Other Programs
+
+	The enumeration and the symmetry analysis of the CPU version, without the command line program:  compile
+	"2DChain Deterministic CPU.cpp" with BUILD_LIBRARY defined, and include this header.
+
+	Codes:  An open chain of Length segments is given by its Length - 2 free turns (0: left, 1: right, first
+	turn after the fixed head in the highest bit), like in the enumeration.  A polygon is given by Length
+	turns, one per atom, including the implicit first left turn and the final turn back to the head.  The
+	primitive code of a polygon is the smallest code among its rotations and reversals; all congruent
+	polygons share it.
+
+	Symmetry Classes:  0 ... 7 for 1, 1m, 2, 2m, 3, 3m, 6, 6m (n-fold rotational symmetry, m: with mirror
+	symmetry), in the order of the census of the program.
+
+	CPU Version 3.28 */
+
+#ifndef TWODCHAIN_LIBRARY_H
+#define TWODCHAIN_LIBRARY_H
+
+#include <stddef.h>
+#include <functional>
+
+/* Chain and Polygon Codes (64 bits) */
+typedef unsigned long long ChainCode;
+
+/* Longest Chains With Codes (polygons up to 63 segments) */
+const int LibraryMaxLength = 63;
+
+/* Chains Passed On by the Enumeration */
+enum ChainSelection
+{
+	SelectOpenChains = 1,		/* self-avoiding open chains */
+	SelectClosedChains = 2,		/* closed self-avoiding chains (polygons, before reduction) */
+	SelectAllChains = 3
+};
+
+/* Called for Each Chain Found (open chain code, true for closed chains):  Return false to Stop */
+typedef std::function<bool (ChainCode Code, bool IsClosed)> ChainCallback;
+
+/* Enumerate All Chains of a Length (3 ... LibraryMaxLength) in Ascending Order of Their Codes, on the Calling
+   Thread, Without Storing Them
+   Function Value Returned is true If the Enumeration Ran Until the End (false: stopped, or length not allowed) */
+bool EnumerateChains (int Length, const ChainCallback &Callback, ChainSelection Selection = SelectAllChains);
+
+/* Same, for Codes FirstCode ... EndCode - 1 Only (to split the work among threads) */
+bool EnumerateChainRange (int Length, ChainCode FirstCode, ChainCode EndCode, const ChainCallback &Callback,
+						  ChainSelection Selection = SelectAllChains);
+
+/* Polygon Code of a Closed Chain, From Its Open Chain Code */
+ChainCode PolygonCode (ChainCode Chain, int Length);
+
+/* Primitive Codes of Polygons (Primitives may be the same array as Polygons) */
+void CanonicalizePolygons (const ChainCode *Polygons, size_t Count, int Length, ChainCode *Primitives);
+
+/* Symmetry Classes of Polygons (0 ... 7, see above) */
+void ClassifyPolygons (const ChainCode *Polygons, size_t Count, int Length, unsigned char *Classes);
+
+/* Lattice Sites of a Polygon, Rebuilt From Its Code (first turn left:  primitive codes, codes from PolygonCode),
+   Grid Coordinates (n1, n2, n3) of Atoms 0 ... Length, Three Entries per Atom (last atom back at the origin) */
+void PolygonSites (ChainCode Polygon, int Length, int *Sites);
+
+#endif